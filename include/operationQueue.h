@@ -19,6 +19,9 @@
 #ifndef workdipatcher_dispatch_h
 #define workdipatcher_dispatch_h
 
+#include <stdint.h>
+#include <time.h>
+
 #ifdef _cplusplus
 extern "C" {
 #endif
@@ -71,6 +74,41 @@ typedef struct _wd_operation_flags_t {
 } wd_operation_flags_t;
 
 
+/*!
+ *  @typedef wd_operation_queue_scheduling_t
+ *  @brief The order in which an operation queue executes its pending operations.
+ *  @ingroup wd
+ */
+typedef enum _wd_operation_queue_scheduling_t {
+	WDOperationQueueSchedulingFIFO = 0, /*!< The operations are executed in the order they were added. This is the default. */
+	WDOperationQueueSchedulingEDF /*!< The operation with the earliest deadline is executed first, the operations without a deadline come last in the order they were added. See @ref WDOperationSetDeadline. */
+} wd_operation_queue_scheduling_t;
+
+/*!
+ *  @typedef wd_operation_queue_deadline_miss_t
+ *  @brief What an operation queue does with a pending operation whose deadline has passed.
+ *  @ingroup wd
+ */
+typedef enum _wd_operation_queue_deadline_miss_t {
+	WDOperationQueueDeadlineMissExecute = 0, /*!< The operation is executed anyway. This is the default. */
+	WDOperationQueueDeadlineMissCancel, /*!< The operation is marked as canceled and finished without being executed. */
+	WDOperationQueueDeadlineMissDrop /*!< The operation is marked as finished without being executed. */
+} wd_operation_queue_deadline_miss_t;
+
+/*!
+ *  @typedef wd_operation_queue_statistics_t
+ *  @brief The counters of an operation queue.
+ *  @ingroup wd
+ *	@details See @ref WDOperationQueueGetStatistics.
+ */
+typedef struct _wd_operation_queue_statistics_t {
+	uint64_t executed; /*!< The number of operations whose function was executed. */
+	uint64_t coalesced; /*!< The number of operations merged into a pending one by @ref WDOperationQueueAddOperationWithKey. */
+	uint64_t deadlinesMet; /*!< The number of operations with a deadline that finished executing in time. */
+	uint64_t deadlinesMissed; /*!< The number of operations with a deadline that were started or finished after it. */
+	uint64_t expired; /*!< The number of operations that were not executed because their deadline passed, see @ref wd_operation_queue_deadline_miss_t. */
+} wd_operation_queue_statistics_t;
+
 /*!
  *  @typedef typedef void (*wd_operation_f) (WDOperation *, void *)
  *  @brief The prororype of an operation's function.
@@ -81,6 +119,17 @@ typedef struct _wd_operation_flags_t {
  */
 typedef void (*wd_operation_f) (WDOperation *operation, void *argument);
 
+/*!
+ *  @typedef typedef void (*wd_operation_merge_f) (void *pendingArgument, void *incomingArgument)
+ *  @brief The prototype of a function merging an incoming operation into a pending one with the same key.
+ *  @ingroup wd
+ *	@details See @ref WDOperationQueueAddOperationWithKey. The function is called while the operation queue is locked, it should be short and must not call back into the queue.
+ *
+ *	@param[in,out] pendingArgument the argument of the operation that is already pending in the queue
+ *	@param[in] incomingArgument the argument of the operation that is being merged and will never be executed
+ */
+typedef void (*wd_operation_merge_f) (void *pendingArgument, void *incomingArgument);
+
 /*!
  *  @fn WDOperation *WDOperationCreate(const wd_operation_f function, void *restrict argument)
  *  @brief Creates an operation.
@@ -139,6 +188,17 @@ void WDOperationQueueRelease(WDOperationQueue *queue);
  */
 void WDOperationCancel(WDOperation *operation);
 
+/*!
+ *  @fn int WDOperationSetDeadline(WDOperation *operation, const struct timespec *deadline)
+ *  @brief Sets the time by which the operation should finish.
+ *  @ingroup wd
+ *	@details The deadline orders the operation in the queues using @ref WDOperationQueueSchedulingEDF and is used to count the deadline misses of every queue (see @ref WDOperationQueueGetStatistics). It must be set before the operation is added to a queue.
+ *	@param[in] operation the operation
+ *	@param[in] deadline the absolute time, measured against `CLOCK_MONOTONIC`, or `NULL` to remove the deadline
+ *	@returns `0` on success, a negative value on failure. `errno` is set to `EBUSY` if the operation is already in a queue.
+ */
+int WDOperationSetDeadline(WDOperation *operation, const struct timespec *deadline);
+
 /*!
  *  @fn wd_operation_flags_t WDOperationGetFlags(WDOperation *operation)
  *  @brief Returns a structure of flags that indicate the state of this operation.
@@ -159,12 +219,32 @@ wd_operation_flags_t WDOperationGetFlags(WDOperation *operation);
  */
 WDOperationQueue *WDOperationCurrentOperationQueue(WDOperation *operation);
 
+/*!
+ *  @fn void WDOperationBeginBlocking(WDOperation *operation)
+ *  @brief Declares that the running operation is about to block.
+ *  @ingroup wd
+ *	@details Call this function from within a running operation before it blocks, on I/O for example, and call @ref WDOperationEndBlocking once it is done. While the operation is blocked its queue may start another worker, within the limits set by @ref WDOperationQueueSetWorkerLimits, so that the pending operations keep being executed. Blocking sections can be nested. Calling this function from outside the context of the running operation has no effect.
+ *	@param[in] operation the running operation
+ */
+void WDOperationBeginBlocking(WDOperation *operation);
+
+/*!
+ *  @fn void WDOperationEndBlocking(WDOperation *operation)
+ *  @brief Declares that the running operation is no longer blocked.
+ *  @ingroup wd
+ *	@details Ends a section started with @ref WDOperationBeginBlocking. A section that is still open when the operation returns is ended automatically.
+ *	@param[in] operation the running operation
+ */
+void WDOperationEndBlocking(WDOperation *operation);
+
 /*!
  *  @fn void WDOperationWaitUntilFinished(WDOperation *operation)
  *  @brief Blocks execution of the current thread until the receiver finishes.
  *  @ingroup wd
  *	@details
- *	This function should never be called in the context of a running operation with the same operation as argument and should avoid calling it passing any operations submitted to the same operation queue as itself. Doing so can cause the operation to deadlock. It is generally safe to call this function with an operation that is in a different operation queue, although it is still possible to create deadlocks if each operation waits on the other.
+ *	This function should never be called in the context of a running operation with the same operation as argument. Doing so causes the operation to deadlock.
+ *
+ *	When called in the context of a running operation the worker thread helps instead of blocking: if the awaited operation is still pending in the same operation queue it is removed from the queue and executed inline, otherwise the other pending operations of the queue are executed inline until none is left. This makes it safe to wait on child operations submitted to the same serial queue, for fork-join recursion for example. If the queue is suspended, or nothing is left to help with, the worker blocks as in a blocking section (see @ref WDOperationBeginBlocking). It is still possible to create deadlocks if operations in different queues wait on each other.
  *
  *	A typical use for this function would be to call it from the code that created the operation in the first place. After submitting the operation to a queue, you would call this function to wait until that operation finished executing.
  *	@param[in] operation the operation that is running in the context of a queue
@@ -181,10 +261,47 @@ void WDOperationWaitUntilFinished(WDOperation *operation);
  *  @fn WDOperationQueue *WDOperationQueueAllocate(void)
  *  @brief Creates an operation queue.
  *  @ingroup wd
+ *	@details The operation queue executes its operations serially on a single worker thread. Use @ref WDOperationQueueSetWorkerLimits to let it execute operations concurrently.
+ *
+ *	Creating a queue does not start any thread, the worker is started when the first operation is added and exits once it has been idle for the idle timeout (see @ref WDOperationQueueSetIdleTimeout). Idle queues are therefore cheap to keep around.
  *	@returns an initialized @ref WDOperationQueue object.
  */
 WDOperationQueue *WDOperationQueueAllocate(void);
 
+/*!
+ *  @fn int WDOperationQueueSetWorkerLimits(WDOperationQueue *queue, unsigned int minimum, unsigned int maximum)
+ *  @brief Sets the number of worker threads of the operation queue.
+ *  @ingroup wd
+ *	@details The queue keeps at least @a minimum workers that are not blocked (see @ref WDOperationBeginBlocking) as long as it has pending operations and never runs more than @a maximum workers. Between these limits a worker is added when the oldest pending operation waited longer than the backlog threshold (see @ref WDOperationQueueSetBacklogThreshold). Every worker retires once it has been idle for the idle timeout (see @ref WDOperationQueueSetIdleTimeout).
+ *
+ *	If @a maximum is greater than `1` the operations of the queue may be executed concurrently. The default limits are `1` and `1`, a serial queue. The limits of the main queue cannot be changed.
+ *	@param[in] queue the operation queue
+ *	@param[in] minimum the number of workers that are not blocked, at least `1`
+ *	@param[in] maximum the maximum number of workers, at least @a minimum
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDOperationQueueSetWorkerLimits(WDOperationQueue *queue, unsigned int minimum, unsigned int maximum);
+
+/*!
+ *  @fn void WDOperationQueueSetIdleTimeout(WDOperationQueue *queue, unsigned int milliseconds)
+ *  @brief Sets how long a worker stays idle before it retires.
+ *  @ingroup wd
+ *	@details The default value is 5 seconds. The main queue is always served by the main thread.
+ *	@param[in] queue the operation queue
+ *	@param[in] milliseconds the idle timeout
+ */
+void WDOperationQueueSetIdleTimeout(WDOperationQueue *queue, unsigned int milliseconds);
+
+/*!
+ *  @fn void WDOperationQueueSetBacklogThreshold(WDOperationQueue *queue, unsigned int milliseconds)
+ *  @brief Sets how long the oldest pending operation may wait before the queue adds a worker.
+ *  @ingroup wd
+ *	@details The age of the oldest pending operation is checked when operations are added, when a worker starts an operation and, while every worker is busy, by a thread shared by all the queues once the threshold is reached. The default value is `0`, the backlog never adds workers.
+ *	@param[in] queue the operation queue
+ *	@param[in] milliseconds the backlog threshold or `0` to disable it
+ */
+void WDOperationQueueSetBacklogThreshold(WDOperationQueue *queue, unsigned int milliseconds);
+
 /*!
  *  @fn int WDOperationQueueAddOperation(WDOperationQueue *restrict queue, WDOperation *restrict operation)
  *  @brief Adds the specified operation object to the queue.
@@ -196,6 +313,52 @@ WDOperationQueue *WDOperationQueueAllocate(void);
  */
 int WDOperationQueueAddOperation(WDOperationQueue *restrict queue, WDOperation *restrict operation);
 
+/*!
+ *  @fn int WDOperationQueueAddOperationWithKey(WDOperationQueue *restrict queue, WDOperation *restrict operation, uint64_t key, wd_operation_merge_f merge)
+ *  @brief Adds the specified operation object to the queue unless an operation with the same key is already pending.
+ *  @ingroup wd
+ *	@details Use this function to coalesce bursts of the same logical work. If an operation that was added with the same @a key is still pending (neither executing nor canceled) then @a operation is not added: @a merge is called with the arguments of both operations, if it is not `NULL`, and @a operation is marked as canceled and finished. Once the pending operation starts executing, its key is released and a new operation with the same key will be added normally.
+ *
+ *	This function can be called from a currently running operation. This function is thread-safe.
+ *	@param[in] queue the operation queue
+ *	@param[in] operation The operation object to be added to the queue. In memory-managed applications, this object is retained by the operation queue (see [libmemorymanagement](https://github.com/averello/memorymanagement)).
+ *	@param[in] key the key identifying the logical work of the operation
+ *	@param[in] merge the function merging @a operation into the pending one or `NULL` to simply drop @a operation
+ *	@returns `0` if the operation was submitted to the operation queue, `1` if it was merged into a pending operation, a negative value on failure
+ */
+int WDOperationQueueAddOperationWithKey(WDOperationQueue *restrict queue, WDOperation *restrict operation, uint64_t key, wd_operation_merge_f merge);
+
+/*!
+ *  @fn int WDOperationQueueSetScheduling(WDOperationQueue *queue, wd_operation_queue_scheduling_t scheduling)
+ *  @brief Sets the order in which the queue executes its pending operations.
+ *  @ingroup wd
+ *	@details The pending operations are reordered immediately. In @ref WDOperationQueueSchedulingEDF the pending operations are kept in a binary heap, adding and starting an operation costs `O(log n)`.
+ *	@param[in] queue the operation queue
+ *	@param[in] scheduling the scheduling of the operation queue
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDOperationQueueSetScheduling(WDOperationQueue *queue, wd_operation_queue_scheduling_t scheduling);
+
+/*!
+ *  @fn void WDOperationQueueSetDeadlineMissPolicy(WDOperationQueue *queue, wd_operation_queue_deadline_miss_t policy)
+ *  @brief Sets what the queue does with the pending operations whose deadline has passed.
+ *  @ingroup wd
+ *	@details The deadline is checked when the operation is about to be executed, see @ref wd_operation_queue_deadline_miss_t.
+ *	@param[in] queue the operation queue
+ *	@param[in] policy the deadline miss policy
+ */
+void WDOperationQueueSetDeadlineMissPolicy(WDOperationQueue *queue, wd_operation_queue_deadline_miss_t policy);
+
+/*!
+ *  @fn int WDOperationQueueGetStatistics(WDOperationQueue *queue, wd_operation_queue_statistics_t *statistics)
+ *  @brief Returns the counters of the operation queue.
+ *  @ingroup wd
+ *	@param[in] queue the operation queue
+ *	@param[out] statistics the counters since the creation of the queue
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDOperationQueueGetStatistics(WDOperationQueue *queue, wd_operation_queue_statistics_t *statistics);
+
 /*!
  *  @fn void WDOperationQueueSuspend(WDOperationQueue *restrict queue, int choice)
  *  @brief Modifies the execution of pending operations
@@ -248,7 +411,7 @@ void WDOperationQueueSetName(WDOperationQueue *queue, const char *name);
  *  @fn const char * WDOperationQueueGetName(WDOperationQueue *queue)
  *  @brief Returns the name of the operation queue.
  *  @ingroup wd
- *	@details The default value of this string is “WDOperationQueue <id>”, where <id> is the memory address of the operation queue.
+ *	@details The default value of this string is “WDOperationQueue <id>”, where <id> is the memory address of the operation queue. The default name is formatted the first time it is requested.
  *	@param[in] queue the operation queue
  *	@returns The name of the operation queue.
  */
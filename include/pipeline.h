@@ -0,0 +1,180 @@
+/*!
+ *  @file pipeline.h
+ *  @brief Multi-Stage Pipelines.
+ *  @details This module chains functions executed on operation queues through bounded rings.
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#ifndef workdipatcher_pipeline_h
+#define workdipatcher_pipeline_h
+
+#include <stddef.h>
+#include "operationQueue.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+/*!
+ *  @typedef typedef struct _wd_pipeline_t WDPipeline
+ *  @brief A pipeline structure.
+ *  @ingroup wd
+ *
+ *
+ *	Overview
+ *	========
+ *	@par
+ *	A `WDPipeline` passes items through a sequence of stages, each stage being a function executed on an operation queue. Instead of creating and adding one operation per item and per stage, the stages are connected by bounded single-producer/single-consumer rings of pointers and a stage executes a whole batch of items per operation. The items of a stage are executed one after the other and in the order they were pushed, even on a queue with several workers.
+ *	@par
+ *	A pipeline is built by adding its stages (@ref WDPipelineAddStage) and then started (@ref WDPipelineStart). Items are then pushed by a single thread (@ref WDPipelinePush). The pushed items are handed to the first stage once a batch is complete or once the flush latency has elapsed, see @ref WDPipelineSetBatchSize and @ref WDPipelineSetFlushLatency.
+ *	@par
+ *	The items are *not* retained, they belong to the stage functions. Each stage returns the item to pass to the next stage, the value returned by the last stage is ignored.
+ */
+typedef struct _wd_pipeline_t WDPipeline;
+
+/*!
+ *  @typedef typedef void *(*wd_pipeline_stage_f) (void *item, void *context)
+ *  @brief The function of a pipeline stage.
+ *  @ingroup wd
+ *	@param[in,out] item the item pushed by the previous stage
+ *	@param[in,out] context the context the stage was added with
+ *	@returns the item to push to the next stage or `NULL` to drop the item
+ */
+typedef void *(*wd_pipeline_stage_f) (void *item, void *context);
+
+/*!
+ *  @typedef wd_pipeline_stage_statistics_t
+ *  @brief The counters of a pipeline stage.
+ *  @ingroup wd
+ *	@details The throughput of a stage is `items / busyTime`, a stage whose queueing delay keeps growing is the bottleneck of the pipeline.
+ */
+typedef struct _wd_pipeline_stage_statistics_t {
+	uint64_t items; /*!< the items executed by the stage */
+	uint64_t batches; /*!< the batches executed by the stage */
+	uint64_t queueingDelay; /*!< the total nanoseconds the items waited in the ring of the stage */
+	uint64_t maximumQueueingDelay; /*!< the longest nanoseconds an item waited in the ring of the stage */
+	uint64_t busyTime; /*!< the nanoseconds spent executing the batches of the stage */
+	size_t pending; /*!< the items currently waiting in the ring of the stage */
+} wd_pipeline_stage_statistics_t;
+
+/*!
+ *  @fn WDPipeline *WDPipelineAllocate(void)
+ *  @brief Creates a pipeline without stages.
+ *  @ingroup wd
+ *	@returns an initialized @ref WDPipeline object or `NULL` on failure.
+ */
+WDPipeline *WDPipelineAllocate(void);
+
+/*!
+ *  @fn WDPipeline *WDPipelineRetain(WDPipeline *pipeline)
+ *  @brief Increments the retain count of a WDPipeline.
+ *  @ingroup wd
+ *	@param[in] pipeline the pipeline to retain.
+ *	@returns the same you passed in as the @a pipeline parameter.
+ */
+WDPipeline *WDPipelineRetain(WDPipeline *pipeline);
+
+/*!
+ *  @fn void WDPipelineRelease(WDPipeline *pipeline)
+ *  @brief Decrements the retain count of a WDPipeline.
+ *  @ingroup wd
+ *	@details The last release flushes the pipeline and waits for all the pushed items to leave it.
+ *	@param[in] pipeline the pipeline to release.
+ *	@warning You should never release the pipeline from within one of its stages.
+ */
+void WDPipelineRelease(WDPipeline *pipeline);
+
+/*!
+ *  @fn int WDPipelineAddStage(WDPipeline *pipeline, WDOperationQueue *queue, wd_pipeline_stage_f function, void *context, size_t capacity)
+ *  @brief Appends a stage to a pipeline.
+ *  @ingroup wd
+ *	@details The queue is retained by the pipeline. The context is neither retained nor released.
+ *	@param[in] pipeline the pipeline, not started yet
+ *	@param[in] queue the operation queue executing the stage
+ *	@param[in] function the function of the stage
+ *	@param[in] context the context passed to @a function
+ *	@param[in] capacity the number of items the ring in front of the stage holds, rounded up to a power of two
+ *	@returns the index of the stage on success, a negative value on failure
+ */
+int WDPipelineAddStage(WDPipeline *pipeline, WDOperationQueue *queue, wd_pipeline_stage_f function, void *context, size_t capacity);
+
+/*!
+ *  @fn int WDPipelineSetBatchSize(WDPipeline *pipeline, size_t batchSize)
+ *  @brief Sets how many items a stage executes per operation.
+ *  @ingroup wd
+ *	@details The first stage is started once @a batchSize items are pushed, the following stages are started by each batch of their previous stage. The default batch size is `64`, `1` hands every item over as soon as it is pushed.
+ *	@param[in] pipeline the pipeline, not started yet
+ *	@param[in] batchSize the number of items of a batch
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDPipelineSetBatchSize(WDPipeline *pipeline, size_t batchSize);
+
+/*!
+ *  @fn int WDPipelineSetFlushLatency(WDPipeline *pipeline, unsigned int microseconds)
+ *  @brief Sets how long the pushed items may wait for their batch to complete.
+ *  @ingroup wd
+ *	@details The default latency is 1 millisecond. A latency of `0` never flushes an incomplete batch, see @ref WDPipelineFlush. The incomplete batches are flushed by a thread of the pipeline that sleeps as long as the first stage is empty.
+ *	@param[in] pipeline the pipeline, not started yet
+ *	@param[in] microseconds the flush latency
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDPipelineSetFlushLatency(WDPipeline *pipeline, unsigned int microseconds);
+
+/*!
+ *  @fn int WDPipelineStart(WDPipeline *pipeline)
+ *  @brief Ends the construction of a pipeline.
+ *  @ingroup wd
+ *	@details No stages can be added to a started pipeline.
+ *	@param[in] pipeline the pipeline
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDPipelineStart(WDPipeline *pipeline);
+
+/*!
+ *  @fn int WDPipelinePush(WDPipeline *pipeline, void *item)
+ *  @brief Pushes an item to the first stage of a pipeline.
+ *  @ingroup wd
+ *	@details A pipeline has a single producer, this function must not be called concurrently for the same pipeline.
+ *	@param[in] pipeline the started pipeline
+ *	@param[in] item the item, not `NULL`
+ *	@returns `0` on success, a negative value on failure with `errno` set to `EAGAIN` when the ring of the first stage is full
+ */
+int WDPipelinePush(WDPipeline *pipeline, void *item);
+
+/*!
+ *  @fn void WDPipelineFlush(WDPipeline *pipeline)
+ *  @brief Hands the pushed items to the first stage without waiting for their batch to complete.
+ *  @ingroup wd
+ *	@param[in] pipeline the started pipeline
+ */
+void WDPipelineFlush(WDPipeline *pipeline);
+
+/*!
+ *  @fn void WDPipelineWaitAllItems(WDPipeline *pipeline)
+ *  @brief Flushes a pipeline and blocks the current thread until all the pushed items leave it.
+ *  @ingroup wd
+ *	@details Must be called by the thread pushing the items.
+ *	@param[in] pipeline the started pipeline
+ */
+void WDPipelineWaitAllItems(WDPipeline *pipeline);
+
+/*!
+ *  @fn int WDPipelineGetStageStatistics(WDPipeline *pipeline, unsigned int stage, wd_pipeline_stage_statistics_t *statistics)
+ *  @brief Retrieves the counters of a pipeline stage.
+ *  @ingroup wd
+ *	@param[in] pipeline the pipeline
+ *	@param[in] stage the index of the stage, see @ref WDPipelineAddStage
+ *	@param[out] statistics the counters of the stage
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDPipelineGetStageStatistics(WDPipeline *pipeline, unsigned int stage, wd_pipeline_stage_statistics_t *statistics);
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
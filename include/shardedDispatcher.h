@@ -0,0 +1,112 @@
+/*!
+ *  @file shardedDispatcher.h
+ *  @brief Key-Affine Sharded Dispatch.
+ *  @details This module dispatches functions in order per key and in parallel across keys.
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#ifndef workdipatcher_shardedDispatcher_h
+#define workdipatcher_shardedDispatcher_h
+
+#include "operationQueue.h"
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+/*!
+ *  @typedef typedef struct _wd_sharded_dispatcher_t WDShardedDispatcher
+ *  @brief A sharded dispatcher structure.
+ *  @ingroup wd
+ *
+ *
+ *	Overview
+ *	========
+ *	@par
+ *	A `WDShardedDispatcher` executes the functions dispatched with the same key in the order they were dispatched and the functions dispatched with different keys in parallel. Each key is hashed to one of a fixed number of serial lanes, the lanes are served by a fixed pool of workers so that millions of distinct keys cost neither a thread nor an operation queue each.
+ *	@par
+ *	A key keeps its lane as long as it has pending functions. When a new key hashes to a lane whose backlog is far above the average, the key is placed in the least loaded lane instead, see @ref WDShardedDispatcherSetRebalanceFactor. Since only keys without pending functions are moved, the order per key is always preserved.
+ */
+typedef struct _wd_sharded_dispatcher_t WDShardedDispatcher;
+
+/*!
+ *  @fn WDShardedDispatcher *WDShardedDispatcherAllocate(unsigned int lanes, unsigned int workers)
+ *  @brief Creates a sharded dispatcher.
+ *  @ingroup wd
+ *	@details The workers are started on demand, see @ref WDOperationQueueAllocate.
+ *	@param[in] lanes the number of serial lanes, typically a small multiple of @a workers
+ *	@param[in] workers the number of worker threads serving the lanes
+ *	@returns an initialized @ref WDShardedDispatcher object or `NULL` on failure.
+ */
+WDShardedDispatcher *WDShardedDispatcherAllocate(unsigned int lanes, unsigned int workers);
+
+/*!
+ *  @fn WDShardedDispatcher *WDShardedDispatcherRetain(WDShardedDispatcher *dispatcher)
+ *  @brief Increments the retain count of a WDShardedDispatcher.
+ *  @ingroup wd
+ *	@param[in] dispatcher the dispatcher to retain.
+ *	@returns the same you passed in as the @a dispatcher parameter.
+ */
+WDShardedDispatcher *WDShardedDispatcherRetain(WDShardedDispatcher *dispatcher);
+
+/*!
+ *  @fn void WDShardedDispatcherRelease(WDShardedDispatcher *dispatcher)
+ *  @brief Decrements the retain count of a WDShardedDispatcher.
+ *  @ingroup wd
+ *	@details The last release waits for all the dispatched functions to finish.
+ *	@param[in] dispatcher the dispatcher to release.
+ *	@warning You should never release the dispatcher from within one of its functions.
+ */
+void WDShardedDispatcherRelease(WDShardedDispatcher *dispatcher);
+
+/*!
+ *  @fn int WDShardedDispatcherDispatch(WDShardedDispatcher *dispatcher, uint64_t key, wd_operation_f function, void *argument)
+ *  @brief Dispatches a function for the specified key.
+ *  @ingroup wd
+ *	@details The function is executed after every function previously dispatched with the same @a key has finished. The @a operation parameter of @a function is the operation executing the lane, it can be used with @ref WDOperationBeginBlocking or @ref WDOperationCurrentOperationQueue. The argument is retained until the function has been executed (see [libmemorymanagement](https://github.com/averello/memorymanagement)).
+ *
+ *	This function is thread-safe.
+ *	@param[in] dispatcher the sharded dispatcher
+ *	@param[in] key the key whose functions are executed in order
+ *	@param[in] function the function to execute
+ *	@param[in,out] argument the argument to pass to @a function
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDShardedDispatcherDispatch(WDShardedDispatcher *dispatcher, uint64_t key, wd_operation_f function, void *argument);
+
+/*!
+ *  @fn void WDShardedDispatcherSetRebalanceFactor(WDShardedDispatcher *dispatcher, unsigned int factor)
+ *  @brief Sets how far above the average a lane's backlog must be before new keys are moved away from it.
+ *  @ingroup wd
+ *	@details The default factor is `4`.
+ *	@param[in] dispatcher the sharded dispatcher
+ *	@param[in] factor the ratio between the backlog of a lane and the average backlog of the lanes or `0` to never move keys
+ */
+void WDShardedDispatcherSetRebalanceFactor(WDShardedDispatcher *dispatcher, unsigned int factor);
+
+/*!
+ *  @fn uint64_t WDShardedDispatcherGetRebalancedKeys(WDShardedDispatcher *dispatcher)
+ *  @brief Returns how many times a key was placed in another lane than its own.
+ *  @ingroup wd
+ *	@param[in] dispatcher the sharded dispatcher
+ *	@returns the number of rebalanced keys
+ */
+uint64_t WDShardedDispatcherGetRebalancedKeys(WDShardedDispatcher *dispatcher);
+
+/*!
+ *  @fn void WDShardedDispatcherWaitAllFunctions(WDShardedDispatcher *dispatcher)
+ *  @brief Blocks the current thread until all the dispatched functions finish executing.
+ *  @ingroup wd
+ *	@param[in] dispatcher the sharded dispatcher
+ */
+void WDShardedDispatcherWaitAllFunctions(WDShardedDispatcher *dispatcher);
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
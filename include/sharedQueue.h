@@ -0,0 +1,172 @@
+/*!
+ *  @file sharedQueue.h
+ *  @brief Cross-Process Operation Queues.
+ *  @details This module shares an operation queue between processes through shared memory.
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#ifndef workdipatcher_sharedQueue_h
+#define workdipatcher_sharedQueue_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+/*!
+ *  @typedef typedef struct _wd_shared_queue_t WDSharedQueue
+ *  @brief A shared operation queue structure.
+ *  @ingroup wd
+ *
+ *
+ *	Overview
+ *	========
+ *	@par
+ *	A `WDSharedQueue` is an operation queue living in a shared memory region (a `memfd` mapped by every process using it), so that operations added by one process are executed by the workers of other processes. Since pointers and functions mean nothing in another process an operation is described by the identifier of a function registered in every process (@ref WDSharedQueueRegisterFunction) and by a payload copied inline in the queue. The workers execute the payload in place, without copying it again.
+ *	@par
+ *	The queue is created by one process (@ref WDSharedQueueCreate) and opened by the others from its file descriptor (@ref WDSharedQueueOpen), inherited through `fork` or passed over a UNIX socket. Idle workers and producers waiting for room sleep on futexes that work across processes.
+ *	@par
+ *	A crashed process is detected and its work is recovered: an operation claimed by a worker that died is executed again by another worker, up to three attempts, and a process that died while holding the lock of the queue leaves it consistent. The operations are therefore executed *at least once*. A worker holds a robust mutex of the region while it executes an operation and the kernel releases that mutex when the worker dies, whether or not its parent has waited for it and in whatever PID namespace it runs. The processes adding, executing or waiting for operations look for such released mutexes every 100 milliseconds, even when they never wait. A worker thread that exits in the middle of an operation is taken for dead as well.
+ *	@par
+ *	Shared queues are available on Linux only, elsewhere every function fails with `ENOSYS`.
+ */
+typedef struct _wd_shared_queue_t WDSharedQueue;
+
+/*!
+ *  @typedef typedef void (*wd_shared_operation_f) (WDSharedQueue *queue, void *payload, size_t size)
+ *  @brief The function of a shared operation.
+ *  @ingroup wd
+ *	@param[in] queue the queue executing the operation
+ *	@param[in,out] payload the payload of the operation, valid only during the call
+ *	@param[in] size the size of the payload
+ */
+typedef void (*wd_shared_operation_f) (WDSharedQueue *queue, void *payload, size_t size);
+
+/*!
+ *  @typedef wd_shared_queue_statistics_t
+ *  @brief The counters of a shared queue, common to all the processes.
+ *  @ingroup wd
+ */
+typedef struct _wd_shared_queue_statistics_t {
+	uint64_t enqueued; /*!< the operations added to the queue */
+	uint64_t executed; /*!< the operations executed */
+	uint64_t recovered; /*!< the operations put back in the queue because their worker died */
+	uint64_t abandoned; /*!< the operations dropped because their function is not registered or because they killed too many workers */
+	uint32_t pending; /*!< the operations waiting in the queue */
+} wd_shared_queue_statistics_t;
+
+/*!
+ *  @fn int WDSharedQueueRegisterFunction(uint32_t identifier, wd_shared_operation_f function)
+ *  @brief Associates a function to an identifier in the current process.
+ *  @ingroup wd
+ *	@details Every process executing shared operations must register the same identifiers for the same functions, typically at startup.
+ *	@param[in] identifier the identifier, lower than `256`
+ *	@param[in] function the function or `NULL` to unregister the identifier
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDSharedQueueRegisterFunction(uint32_t identifier, wd_shared_operation_f function);
+
+/*!
+ *  @fn WDSharedQueue *WDSharedQueueCreate(const char *name, unsigned int capacity, size_t payloadSize)
+ *  @brief Creates a shared queue in a new shared memory region.
+ *  @ingroup wd
+ *	@details The file descriptor of the region is close-on-exec, see @ref WDSharedQueueGetFileDescriptor.
+ *	@param[in] name the name of the region, for debugging
+ *	@param[in] capacity the maximum number of pending and executing operations
+ *	@param[in] payloadSize the maximum size of the payload of an operation
+ *	@returns an initialized @ref WDSharedQueue object or `NULL` on failure.
+ */
+WDSharedQueue *WDSharedQueueCreate(const char *name, unsigned int capacity, size_t payloadSize);
+
+/*!
+ *  @fn WDSharedQueue *WDSharedQueueOpen(int fd)
+ *  @brief Opens a shared queue created by another process.
+ *  @ingroup wd
+ *	@details The file descriptor is duplicated, the caller may close it.
+ *	@param[in] fd the file descriptor of the region
+ *	@returns an initialized @ref WDSharedQueue object or `NULL` on failure.
+ */
+WDSharedQueue *WDSharedQueueOpen(int fd);
+
+/*!
+ *  @fn int WDSharedQueueGetFileDescriptor(WDSharedQueue *queue)
+ *  @brief Returns the file descriptor of the region of a shared queue.
+ *  @ingroup wd
+ *	@details Clear its `FD_CLOEXEC` flag to hand it to a program started with `exec`.
+ *	@param[in] queue the shared queue
+ *	@returns the file descriptor or `-1` on failure
+ */
+int WDSharedQueueGetFileDescriptor(WDSharedQueue *queue);
+
+/*!
+ *  @fn WDSharedQueue *WDSharedQueueRetain(WDSharedQueue *queue)
+ *  @brief Increments the retain count of a WDSharedQueue.
+ *  @ingroup wd
+ *	@param[in] queue the queue to retain.
+ *	@returns the same you passed in as the @a queue parameter.
+ */
+WDSharedQueue *WDSharedQueueRetain(WDSharedQueue *queue);
+
+/*!
+ *  @fn void WDSharedQueueRelease(WDSharedQueue *queue)
+ *  @brief Decrements the retain count of a WDSharedQueue.
+ *  @ingroup wd
+ *	@details The last release unmaps the region from the current process, the region lives as long as a process maps it.
+ *	@param[in] queue the queue to release.
+ */
+void WDSharedQueueRelease(WDSharedQueue *queue);
+
+/*!
+ *  @fn int WDSharedQueueAddOperation(WDSharedQueue *queue, uint32_t function, const void *payload, size_t size, int timeout)
+ *  @brief Adds an operation to a shared queue.
+ *  @ingroup wd
+ *	@details The payload is copied in the queue.
+ *	@param[in] queue the shared queue
+ *	@param[in] function the identifier of the function to execute
+ *	@param[in] payload the payload passed to the function
+ *	@param[in] size the size of the payload, at most the payload size of the queue
+ *	@param[in] timeout the milliseconds to wait for room in the queue, `0` to never wait, `-1` to wait for ever
+ *	@returns `0` on success, a negative value on failure with `errno` set to `EAGAIN` when the queue is full and @a timeout is `0`, to `ETIMEDOUT` when the queue stayed full or to `ECANCELED` when the queue is shut down
+ */
+int WDSharedQueueAddOperation(WDSharedQueue *queue, uint32_t function, const void *payload, size_t size, int timeout);
+
+/*!
+ *  @fn int WDSharedQueuePerformNext(WDSharedQueue *queue, int timeout)
+ *  @brief Executes the oldest pending operation of a shared queue in the current thread.
+ *  @ingroup wd
+ *	@details A worker process typically calls this function in a loop until it fails with `ECANCELED`.
+ *	@param[in] queue the shared queue
+ *	@param[in] timeout the milliseconds to wait for an operation, `0` to never wait, `-1` to wait for ever
+ *	@returns `0` when an operation was executed, a negative value on failure with `errno` set to `EAGAIN` when the queue is empty and @a timeout is `0`, to `ETIMEDOUT` when no operation was added in time, to `ECANCELED` when the queue is shut down and empty or to `ENOENT` when the function of the operation is not registered
+ */
+int WDSharedQueuePerformNext(WDSharedQueue *queue, int timeout);
+
+/*!
+ *  @fn void WDSharedQueueShutdown(WDSharedQueue *queue)
+ *  @brief Refuses new operations and lets the workers return once the queue is empty.
+ *  @ingroup wd
+ *	@param[in] queue the shared queue
+ */
+void WDSharedQueueShutdown(WDSharedQueue *queue);
+
+/*!
+ *  @fn int WDSharedQueueGetStatistics(WDSharedQueue *queue, wd_shared_queue_statistics_t *statistics)
+ *  @brief Retrieves the counters of a shared queue.
+ *  @ingroup wd
+ *	@param[in] queue the shared queue
+ *	@param[out] statistics the counters of the queue
+ *	@returns `0` on success, a negative value on failure
+ */
+int WDSharedQueueGetStatistics(WDSharedQueue *queue, wd_shared_queue_statistics_t *statistics);
+
+#ifdef _cplusplus
+}
+#endif
+
+#endif
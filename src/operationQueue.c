@@ -13,6 +13,7 @@
 #include <pthread.h>
 #include <sys/queue.h>
 #include <errno.h>
+#include <time.h>
 
 #include <memory_management/memory_management.h>
 #include "operationQueue.h"
@@ -26,88 +27,278 @@
 
 #define WDOperationQueueResultSuccess 0
 #define WDOperationQueueResultFailure 1
+#define WDOperationQueueResultCoalesced 1
+
+#define WDOperationQueueIndexInitialCapacity 16
+#define WDOperationQueueDefaultIdleTimeout 5000 /* milliseconds */
+#define WDOperationQueueHeapInitialCapacity 64
+
+#define WDCacheLineSize 64
+
+#define WDOperationFlagCanceled (1u << 0)
+#define WDOperationFlagFinished (1u << 1)
+#define WDOperationFlagExecuting (1u << 2)
 
 static void __initMainQueue() __attribute__((constructor));
 
+struct _wd_operation_queue_worker_t;
+
 void WDOperationDealloc(void *block) __attribute__((visibility("internal")));
 void WDOperationQueueDealloc(void *queue) __attribute__((visibility("internal")));
 void *WDOperationQueueThreadF(void *args) __attribute__((visibility("internal")));
+void *WDOperationQueueWatchdogF(void *args) __attribute__((visibility("internal")));
 WDOperation *WDOperationQueuePopOperation(WDOperationQueue *restrict queue) __attribute__((visibility("internal")));
-void WDOperationQueuePopAndPerform(WDOperationQueue *restrict queue) __attribute__((visibility("internal")));
-void WDOperationPerform(WDOperation *restrict block) __attribute__((visibility("internal")));
+void WDOperationQueueGrowIfNeeded(WDOperationQueue *restrict queue) __attribute__((visibility("internal")));
+void WDOperationQueueExecute(struct _wd_operation_queue_worker_t *worker, WDOperation *operation) __attribute__((visibility("internal")));
+int WDOperationQueueHelp(struct _wd_operation_queue_worker_t *worker, WDOperation *operation) __attribute__((visibility("internal")));
+int WDOperationPerform(WDOperation *restrict block) __attribute__((visibility("internal")));
+void WDOperationFinish(WDOperation *restrict operation) __attribute__((visibility("internal")));
+int WDOperationQueueEnqueue(WDOperationQueue *restrict queue, WDOperation *restrict operation, int keyed, uint64_t key, wd_operation_merge_f merge) __attribute__((visibility("internal")));
 
 /*!
  *  @struct _wd_operation_t
  *  @brief The operation structure.
  *  @ingroup wd
+ *	@details The fields read on every execution come first and share a cache line.
  */
 struct _wd_operation_t {
 	wd_operation_f queuef; /*!< the operation's function */
 	void *argument; /*!< the operation's argument */
-	WDOperationQueue *queue; /*!< the associated queue that launched this operation */
+	unsigned int flags; /*!< the flags of the operation, see `WDOperationFlagCanceled`, only accessed atomically */
+	uint64_t deadline; /*!< the monotonic time in nanoseconds the operation should finish by, `0` if none */
+	WDOperationQueue *queue; /*!< the associated queue that launched this operation, protected by `guard.mutex` */
+	struct _list_item *item; /*!< the entry of the operation while it is pending, protected by the queue's `guard.mutex` */
 	struct _wd_operation_guard_t {
 		pthread_mutex_t mutex;
-		pthread_cond_t condition;
 	} guard; /*!< the data used for thread safety */
 	struct _wd_operation_wait_t {
 		pthread_mutex_t mutex;
 		pthread_cond_t condition;
 	} wait; /*!< the associated data for use with @ref WDOperationWaitUntilFinished */
-	wd_operation_flags_t flags; /*!< the flags of the operations */
 };
 
 struct _list_item {
 	WDOperation *operation;
 	TAILQ_ENTRY(_list_item) items;
+	uint64_t enqueued; /*!< the monotonic time in nanoseconds the operation was added to the queue */
+	uint64_t deadline; /*!< the operation's deadline, `UINT64_MAX` if none */
+	uint64_t sequence; /*!< the order of arrival, breaks the ties between equal deadlines */
+	size_t heapIndex; /*!< the position in the queue's deadline heap, valid only in @ref WDOperationQueueSchedulingEDF */
+	LIST_ENTRY(_list_item) bucket; /*!< the chain in the queue's key index, valid only if `keyed` */
+	uint64_t key; /*!< the coalescing key, see @ref WDOperationQueueAddOperationWithKey */
+	int keyed; /*!< whether the item is present in the queue's key index */
+};
+
+/*!
+ *  @struct _wd_operation_queue_worker_t
+ *  @brief A thread serving an operation queue.
+ *  @ingroup wd
+ */
+struct _wd_operation_queue_worker_t {
+	pthread_t thread; /*!< the worker's thread */
+	WDOperationQueue *queue; /*!< the operation queue served by the worker */
+	WDOperation *executingOperation; /*!< the operation executed by the worker, protected by the queue's `guard.mutex` */
+	unsigned int blocking; /*!< the nesting depth of the blocking sections of the executing operation, see @ref WDOperationBeginBlocking */
+	LIST_ENTRY(_wd_operation_queue_worker_t) workers;
 };
 
 /*!
  *  @struct _wd_operation_queue_t
  *  @brief The operation queue structure.
  *  @ingroup wd
+ *	@details The fields are grouped by the threads that write them: the pending operations written by the producers and by the workers taking them, the state written only by the workers and the read-mostly configuration. The padding keeps the groups on distinct cache lines whatever the alignment of the allocation.
  */
 struct _wd_operation_queue_t {
-	TAILQ_HEAD(ListHead, _list_item) operations; /*!< the operation list */
-
-	const char *name; /*!< the name of the operation queue */
-	pthread_t thread; /*!< the operations queue's private thread */
-
-	WDOperation *executingOperation;
-	
 	struct _wd_operation_queue_guard_t {
 		pthread_mutex_t mutex;
-		pthread_cond_t condition;
+		pthread_cond_t condition; /*!< signaled when operations are pending or when the queue is resumed */
 	} guard; /*!< the data used for thread safety */
-
-	struct _wd_operation_queue_suspend_t {
-		pthread_mutex_t mutex;
-		pthread_cond_t condition;
-	} suspend; /*!< the data associated to suspend operations */
+	
+	TAILQ_HEAD(ListHead, _list_item) operations; /*!< the operation list */
+	
+	struct _wd_operation_queue_schedule_t {
+		struct _list_item **heap; /*!< the pending operations ordered by deadline, used only in @ref WDOperationQueueSchedulingEDF */
+		size_t count; /*!< the number of operations in the heap */
+		size_t capacity; /*!< the capacity of the heap */
+		uint64_t sequence; /*!< the sequence of the next added operation */
+		wd_operation_queue_scheduling_t scheduling; /*!< the order in which pending operations are executed */
+		wd_operation_queue_deadline_miss_t missPolicy; /*!< what to do with the operations whose deadline passed */
+	} schedule; /*!< the scheduling of the pending operations, protected by `guard.mutex` */
+	
+	struct _wd_operation_queue_index_t {
+		LIST_HEAD(BucketHead, _list_item) *buckets; /*!< the buckets, a power of two */
+		size_t capacity; /*!< the number of buckets */
+		size_t count; /*!< the number of keyed pending operations */
+	} index; /*!< the index of the pending keyed operations, protected by `guard.mutex` */
+	
+	uint64_t coalesced; /*!< the number of operations merged by @ref WDOperationQueueAddOperationWithKey, protected by `guard.mutex` */
+	
+	char producerPadding[WDCacheLineSize];
+	
+	struct _wd_operation_queue_pool_t {
+		LIST_HEAD(WorkerHead, _wd_operation_queue_worker_t) active; /*!< the running workers, detached so that an exited one holds no stack */
+		pthread_cond_t condition; /*!< signaled when the queue drains or when a worker exits */
+		unsigned int count; /*!< the number of running workers */
+		unsigned int idle; /*!< the number of workers waiting for operations */
+		unsigned int blocked; /*!< the number of workers in a blocking section */
+		unsigned int executing; /*!< the number of workers executing an operation */
+	} pool; /*!< the workers of the operation queue, protected by `guard.mutex` */
+	
+	struct _wd_operation_queue_counters_t {
+		uint64_t executed;
+		uint64_t deadlinesMet;
+		uint64_t deadlinesMissed;
+		uint64_t expired;
+	} counters; /*!< the counters updated by the workers, protected by `guard.mutex`, see @ref wd_operation_queue_statistics_t */
+	
+	char consumerPadding[WDCacheLineSize];
 	
 	struct _wd_operation_queue_flags_t {
-		unsigned int stop:1; /*!< indicates whether the queue should stop and not to shcedule any further operations for execution */
-		unsigned int suspend:1; /*!< indicates whether the queue is suspended */
-	} flags; /*!< the flags of the operations */
+		int stop; /*!< indicates whether the queue should stop and not to shcedule any further operations for execution */
+		int suspend; /*!< indicates whether the queue is suspended */
+	} flags; /*!< the flags of the operations, written atomically under `guard.mutex` and read atomically without it */
+	
+	struct _wd_operation_queue_limits_t {
+		unsigned int minimum; /*!< the number of workers that are not blocked the pool tries to keep while operations are pending */
+		unsigned int maximum; /*!< the maximum number of workers */
+		unsigned int idleTimeout; /*!< the milliseconds after which an idle worker retires */
+		unsigned int backlogThreshold; /*!< the age in milliseconds of the oldest pending operation that adds a worker, `0` to disable */
+	} limits; /*!< the limits of the pool, protected by `guard.mutex` */
+	
+	struct _wd_operation_queue_watch_t {
+		uint64_t due; /*!< when the oldest pending operation reaches the backlog threshold */
+		int armed; /*!< whether the queue is in the list of the watchdog */
+		LIST_ENTRY(_wd_operation_queue_t) queues;
+	} watch; /*!< the registration of the queue with the backlog watchdog, protected by `__watchdog.mutex` */
+	
+	const char *name; /*!< the name of the operation queue, `NULL` until it is set or first requested */
+	char defaultName[sizeof("WDOperationQueue 0x") + 2 * sizeof(void *)]; /*!< the storage of the default name, see @ref WDOperationQueueGetName */
 };
 
+static inline unsigned int __operationFlags(WDOperation *operation) {
+	return __atomic_load_n(&operation->flags, __ATOMIC_ACQUIRE);
+}
+
+static inline void __operationSetFlags(WDOperation *operation, unsigned int flags) {
+	__atomic_fetch_or(&operation->flags, flags, __ATOMIC_ACQ_REL);
+}
+
+static inline void __operationClearFlags(WDOperation *operation, unsigned int flags) {
+	__atomic_fetch_and(&operation->flags, ~flags, __ATOMIC_ACQ_REL);
+}
+
 static struct _wd_operation_queue_t __mainQueue;
+static pthread_key_t __workerKey;
+
+/*!
+ *  @struct _wd_operation_queue_watchdog_t
+ *  @brief The thread checking the age of the backlogs when every worker is busy.
+ *  @ingroup wd
+ *	@details A single thread serves every queue of the process, it is started the first time a queue is armed and sleeps as long as no queue is armed. It locks a queue's `guard.mutex` without holding its own mutex, the queues lock the watchdog's mutex with their `guard.mutex` held.
+ */
+static struct _wd_operation_queue_watchdog_t {
+	pthread_mutex_t mutex;
+	pthread_cond_t condition; /*!< signaled when a queue is armed or when an inspection ends */
+	LIST_HEAD(WatchHead, _wd_operation_queue_t) queues; /*!< the armed queues */
+	WDOperationQueue *inspecting; /*!< the queue whose backlog is being checked */
+	int running;
+} __watchdog = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, LIST_HEAD_INITIALIZER(__watchdog.queues), NULL, 0 };
 
 
 /* Operation Queue */
 
 static void __initMainQueue() {
 	__mainQueue = (struct _wd_operation_queue_t){
-		{ 0 , 0 },		/* operations */
-		"WDOperationQueue Main Queue",	/* name */
-		pthread_self(),	/* thread */
-		NULL,			/* executingOperation */
-		{ PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER }, /* guard */
-		{ PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER }, /* suspend */
-		{ 0, 0 }		/* flags */
+		.guard = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER },
+		.schedule = { NULL, 0, 0, 0, WDOperationQueueSchedulingFIFO, WDOperationQueueDeadlineMissExecute },
+		.pool = { { NULL }, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0 },
+		.limits = { 1, 1, 0, 0 },
+		.name = NULL
 	};
 	TAILQ_INIT(&__mainQueue.operations);
+	LIST_INIT(&__mainQueue.pool.active);
+	pthread_key_create(&__workerKey, NULL);
+}
+
+static inline uint64_t __now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static int __poolSpawnWorker(WDOperationQueue *queue) {
+	struct _wd_operation_queue_worker_t *worker = calloc(1, sizeof(struct _wd_operation_queue_worker_t));
+	if (NULL == worker) return errno = ENOMEM, -WDOperationQueueResultFailure;
+	worker->queue = queue;
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+	int error = pthread_create(&worker->thread, &attributes, WDOperationQueueThreadF, worker);
+	pthread_attr_destroy(&attributes);
+	if (error != 0)
+		return free(worker), errno = EAGAIN, -WDOperationQueueResultFailure;
+	LIST_INSERT_HEAD(&queue->pool.active, worker, workers);
+	queue->pool.count++;
+	return WDOperationQueueResultSuccess;
+}
+
+/* Asks the watchdog to check the backlog again at `due`, the caller holds `guard.mutex` */
+static void __watchdogArm(WDOperationQueue *queue, uint64_t due) {
+	pthread_mutex_lock(&__watchdog.mutex);
+	/* An earlier check re-arms the queue if needed, the oldest pending operation only gets younger */
+	if (!queue->watch.armed) {
+		if (!__watchdog.running) {
+			pthread_t thread;
+			pthread_attr_t attributes;
+			pthread_attr_init(&attributes);
+			pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+			__watchdog.running = pthread_create(&thread, &attributes, WDOperationQueueWatchdogF, NULL) == 0;
+			pthread_attr_destroy(&attributes);
+		}
+		if (__watchdog.running) {
+			queue->watch.due = due;
+			queue->watch.armed = 1;
+			LIST_INSERT_HEAD(&__watchdog.queues, queue, watch.queues);
+			pthread_cond_broadcast(&__watchdog.condition);
+		}
+	}
+	pthread_mutex_unlock(&__watchdog.mutex);
 }
 
+/* Removes the queue from the watchdog and waits for an ongoing check, the caller holds no lock */
+static void __watchdogForget(WDOperationQueue *queue) {
+	pthread_mutex_lock(&__watchdog.mutex);
+	if (queue->watch.armed) {
+		LIST_REMOVE(queue, watch.queues);
+		queue->watch.armed = 0;
+	}
+	while (__watchdog.inspecting == queue)
+		pthread_cond_wait(&__watchdog.condition, &__watchdog.mutex);
+	pthread_mutex_unlock(&__watchdog.mutex);
+}
+
+static int __poolShouldGrow(WDOperationQueue *queue) {
+	struct _wd_operation_queue_pool_t *pool = &queue->pool;
+	/* The main queue is served only by the main thread */
+	if (queue == &__mainQueue) return 0;
+	if (queue->flags.stop || queue->flags.suspend) return 0;
+	if (TAILQ_EMPTY(&queue->operations) || pool->idle > 0 || pool->count >= queue->limits.maximum) return 0;
+	/* Replace the workers that are stuck in a blocking section */
+	if (pool->count - pool->blocked < queue->limits.minimum) return 1;
+	/* Help when the oldest pending operation waits for too long */
+	if (queue->limits.backlogThreshold > 0) {
+		uint64_t due = TAILQ_FIRST(&queue->operations)->enqueued + (uint64_t)queue->limits.backlogThreshold * 1000000;
+		if (__now() >= due) return 1;
+		/* The busy workers may not come back in time to check again */
+		__watchdogArm(queue, due);
+	}
+	return 0;
+}
+
+void WDOperationQueueGrowIfNeeded(WDOperationQueue *restrict queue) {
+	if (__poolShouldGrow(queue))
+		__poolSpawnWorker(queue);
+}
 
 WDOperationQueue *WDOperationQueueAllocate(void) {
 	WDOperationQueue *queue = MEMORY_MANAGEMENT_ALLOC(sizeof(WDOperationQueue));
@@ -116,57 +307,59 @@ WDOperationQueue *WDOperationQueueAllocate(void) {
 	TAILQ_INIT(&queue->operations);
 	pthread_mutex_init(&queue->guard.mutex, NULL);
 	pthread_cond_init(&queue->guard.condition, NULL);
-	pthread_mutex_init(&queue->suspend.mutex, NULL);
-	pthread_cond_init(&queue->suspend.condition, NULL);
+	LIST_INIT(&queue->pool.active);
+	pthread_cond_init(&queue->pool.condition, NULL);
+	queue->limits.minimum = queue->limits.maximum = 1;
+	queue->limits.idleTimeout = WDOperationQueueDefaultIdleTimeout;
 	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(queue, WDOperationQueueDealloc);
 	
-	size_t size = (size_t)snprintf(NULL, 0, "WDOperationQueue %p", (void *)queue);
-	char *name = calloc(size+1, sizeof(char));
-	snprintf(name, size+1, "WDOperationQueue %p", (void *)queue);
-	queue->name = name;
-	
-	pthread_create(&queue->thread, NULL, WDOperationQueueThreadF, queue);
-	
+	/* The name and the first worker are created on demand */
 	return queue;
 }
 
 void WDOperationQueueDealloc(void *_queue) {
 	if (NULL == _queue) return;
 	WDOperationQueue *queue = _queue;
-	/* Indicate that the internal thread should stop */
+	struct _wd_operation_queue_worker_t *worker;
+	
 	pthread_mutex_lock(&queue->guard.mutex);
-	queue->flags.stop = 1;
+	/* Indicate that the workers should stop */
+	__atomic_store_n(&queue->flags.stop, 1, __ATOMIC_RELEASE);
+	/* Cancel the running operations */
+	LIST_FOREACH(worker, &queue->pool.active, workers) {
+		if (NULL != worker->executingOperation)
+			WDOperationCancel(worker->executingOperation);
+	}
+	/* Wake up the idle workers */
+	pthread_cond_broadcast(&queue->guard.condition);
+	/* Wait the workers to finish */
+	while (queue->pool.count > 0)
+		pthread_cond_wait(&queue->pool.condition, &queue->guard.mutex);
 	pthread_mutex_unlock(&queue->guard.mutex);
+	/* The stopped queue is never armed again */
+	__watchdogForget(queue);
 
 	/* Remove all pending operations, they will never be executed */
 	struct _list_item *item, *tmp;
 	TAILQ_FOREACH_SAFE(item, &queue->operations, items, tmp) {
 		if (NULL == item) break;
 		TAILQ_REMOVE(&queue->operations, item, items);
+		item->operation->item = NULL;
 		release(item->operation);
 		release(item);
 	}
+	free(queue->index.buckets);
+	queue->index = (struct _wd_operation_queue_index_t){ NULL, 0, 0 };
+	free(queue->schedule.heap);
+	queue->schedule.heap = NULL, queue->schedule.count = queue->schedule.capacity = 0;
 	
-	if (NULL != queue->name)
+	if (NULL != queue->name && queue->name != queue->defaultName)
 		free((void *)queue->name);
 	
-	/* 
-	 If there is no operation running on the queue then cancel the thread
-	 This will has as result to wake up the thread that probably is
-	 blocked in a pthread_mutex_wait() call in WDOperationQueuePopAndPerform().
-	 */
-	if (queue->executingOperation==NULL)
-		pthread_cancel(queue->thread);
-	/* Otherwise cancel the running operation */
-	else
-		WDOperationCancel(queue->executingOperation);
-	
-	/* Wait the worker/internal thread to finish */
-	pthread_join(queue->thread, NULL);
-	
 	/* Clean up */
 	pthread_mutex_destroy(&queue->guard.mutex);
 	pthread_cond_destroy(&queue->guard.condition);
+	pthread_cond_destroy(&queue->pool.condition);
 }
 
 WDOperationQueue *WDOperationQueueRetain(WDOperationQueue *queue) {
@@ -181,31 +374,312 @@ void WDOperationQueueRelease(WDOperationQueue *queue) {
 
 void WDOperationQueueSetName(WDOperationQueue *queue, const char *name) {
 	if (NULL == queue) return;
-	if (NULL != queue->name)
-		free((void *)queue->name), queue->name = NULL;
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (NULL != queue->name && queue->name != queue->defaultName)
+		free((void *)queue->name);
 	queue->name = strdup(name);
+	pthread_mutex_unlock(&queue->guard.mutex);
 }
 
 const char * WDOperationQueueGetName(WDOperationQueue *queue) {
 	if (NULL == queue) return errno = EINVAL, NULL;
-	return queue->name;
+	pthread_mutex_lock(&queue->guard.mutex);
+	/* Format the default name the first time it is requested */
+	if (NULL == queue->name) {
+		if (queue == &__mainQueue)
+			snprintf(queue->defaultName, sizeof(queue->defaultName), "WDOperationQueue Main Queue");
+		else
+			snprintf(queue->defaultName, sizeof(queue->defaultName), "WDOperationQueue %p", (void *)queue);
+		queue->name = queue->defaultName;
+	}
+	const char *name = queue->name;
+	pthread_mutex_unlock(&queue->guard.mutex);
+	return name;
+}
+
+int WDOperationQueueSetWorkerLimits(WDOperationQueue *queue, unsigned int minimum, unsigned int maximum) {
+	if (NULL == queue) return errno = EINVAL, -WDOperationQueueResultFailure;
+	/* The main queue is served only by the main thread */
+	if (queue == &__mainQueue) return errno = EINVAL, -WDOperationQueueResultFailure;
+	if (minimum == 0 || minimum > maximum) return errno = EINVAL, -WDOperationQueueResultFailure;
+	
+	pthread_mutex_lock(&queue->guard.mutex);
+	queue->limits.minimum = minimum;
+	queue->limits.maximum = maximum;
+	/* Bring the pool up to its new minimum if operations are pending */
+	int result = WDOperationQueueResultSuccess;
+	while (__poolShouldGrow(queue) && result == WDOperationQueueResultSuccess)
+		result = __poolSpawnWorker(queue);
+	pthread_mutex_unlock(&queue->guard.mutex);
+	return result;
+}
+
+void WDOperationQueueSetIdleTimeout(WDOperationQueue *queue, unsigned int milliseconds) {
+	if (NULL == queue) { errno = EINVAL; return; }
+	pthread_mutex_lock(&queue->guard.mutex);
+	queue->limits.idleTimeout = milliseconds;
+	pthread_mutex_unlock(&queue->guard.mutex);
+}
+
+void WDOperationQueueSetBacklogThreshold(WDOperationQueue *queue, unsigned int milliseconds) {
+	if (NULL == queue) { errno = EINVAL; return; }
+	pthread_mutex_lock(&queue->guard.mutex);
+	queue->limits.backlogThreshold = milliseconds;
+	pthread_mutex_unlock(&queue->guard.mutex);
+}
+
+void WDOperationQueueExecute(struct _wd_operation_queue_worker_t *worker, WDOperation *operation) {
+	WDOperationQueue *queue = worker->queue;
+	struct _wd_operation_queue_pool_t *pool = &queue->pool;
+	/* The worker may be helping from within another operation, see WDOperationWaitUntilFinished() */
+	WDOperation *outerOperation = worker->executingOperation;
+	unsigned int outerBlocking = worker->blocking;
+	worker->executingOperation = operation;
+	worker->blocking = 0;
+	pool->executing++;
+	/* The deadline of the operation passed while it was pending */
+	uint64_t deadline = operation->deadline;
+	int late = deadline && __now() > deadline, drop = 0;
+	if (late) {
+		queue->counters.deadlinesMissed++;
+		if (queue->schedule.missPolicy != WDOperationQueueDeadlineMissExecute) {
+			queue->counters.expired++;
+			if (queue->schedule.missPolicy == WDOperationQueueDeadlineMissCancel)
+				WDOperationCancel(operation);
+			else
+				drop = 1;
+		}
+	}
+	/* The next operation may already be waiting for too long */
+	WDOperationQueueGrowIfNeeded(queue);
+	pthread_mutex_unlock(&queue->guard.mutex);
+	
+	int executed = 0;
+	if (drop) {
+		/* Disassociate the operation from the queue as WDOperationPerform() does */
+		pthread_mutex_lock(&operation->guard.mutex);
+		operation->queue = NULL;
+		pthread_mutex_unlock(&operation->guard.mutex);
+		WDOperationFinish(operation);
+	}
+	else
+		executed = WDOperationPerform(operation);
+	uint64_t finished = (executed && deadline && !late) ? __now() : 0;
+	
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (executed) queue->counters.executed++;
+	if (finished) {
+		if (finished <= deadline) queue->counters.deadlinesMet++;
+		else queue->counters.deadlinesMissed++;
+	}
+	/* The operation did not end its blocking section */
+	if (worker->blocking) pool->blocked--;
+	worker->executingOperation = outerOperation;
+	worker->blocking = outerBlocking;
+	pool->executing--;
+	/* Inform anyone waiting in WDOperationQueueWaitAllOperations() */
+	if (pool->executing == 0 && TAILQ_EMPTY(&queue->operations))
+		pthread_cond_broadcast(&pool->condition);
+	pthread_mutex_unlock(&queue->guard.mutex);
+	release(operation);
+	pthread_mutex_lock(&queue->guard.mutex);
 }
 
 void *WDOperationQueueThreadF(void *args) {
-	WDOperationQueue *queue = (WDOperationQueue *)args;
+	struct _wd_operation_queue_worker_t *worker = args;
+	WDOperationQueue *queue = worker->queue;
+	struct _wd_operation_queue_pool_t *pool = &queue->pool;
+	pthread_setspecific(__workerKey, worker);
 	
+	pthread_mutex_lock(&queue->guard.mutex);
 	while (!queue->flags.stop) {
-		pthread_mutex_lock(&queue->suspend.mutex);
-		if (queue->flags.suspend)
-			pthread_cond_wait(&queue->suspend.condition, &queue->suspend.mutex);
-		pthread_mutex_unlock(&queue->suspend.mutex);
-		WDOperationQueuePopAndPerform(queue);
+		/* Block if there is no operation in the queue or if it is suspended */
+		if (queue->flags.suspend || TAILQ_EMPTY(&queue->operations)) {
+			int expired = 0;
+			pool->idle++;
+			/* The main thread serves the main queue for ever */
+			if (queue != &__mainQueue) {
+				struct timespec deadline;
+				clock_gettime(CLOCK_REALTIME, &deadline);
+				deadline.tv_sec += queue->limits.idleTimeout / 1000;
+				deadline.tv_nsec += (long)(queue->limits.idleTimeout % 1000) * 1000000;
+				if (deadline.tv_nsec >= 1000000000) deadline.tv_sec++, deadline.tv_nsec -= 1000000000;
+				expired = pthread_cond_timedwait(&queue->guard.condition, &queue->guard.mutex, &deadline) == ETIMEDOUT;
+			}
+			else
+				pthread_cond_wait(&queue->guard.condition, &queue->guard.mutex);
+			pool->idle--;
+			/* Retire the workers that stayed idle for too long, new ones are started on demand */
+			if (expired && (queue->flags.suspend || TAILQ_EMPTY(&queue->operations)))
+				break;
+			continue;
+		}
+		
+		WDOperationQueueExecute(worker, WDOperationQueuePopOperation(queue));
 	}
+	
+	/* Leave the pool, WDOperationQueueDealloc() waits for the count to reach zero and the queue is not touched after the unlock */
+	LIST_REMOVE(worker, workers);
+	/* The worker of the main thread lives on its stack */
+	if (queue != &__mainQueue) free(worker);
+	pool->count--;
+	pthread_cond_broadcast(&pool->condition);
+	pthread_mutex_unlock(&queue->guard.mutex);
 	/* If any operaitons are still in the queue then WDOperationQueueDealloc() will take care of them */
 	return (void *)NULL;
 }
 
-int WDOperationQueueAddOperation(WDOperationQueue *restrict queue, WDOperation *restrict operation) {
+void *WDOperationQueueWatchdogF(void *args) {
+	(void)args;
+	pthread_mutex_lock(&__watchdog.mutex);
+	for (;;) {
+		WDOperationQueue *queue, *next = NULL;
+		LIST_FOREACH(queue, &__watchdog.queues, watch.queues) {
+			if (NULL == next || queue->watch.due < next->watch.due)
+				next = queue;
+		}
+		if (NULL == next) {
+			pthread_cond_wait(&__watchdog.condition, &__watchdog.mutex);
+			continue;
+		}
+		uint64_t now = __now();
+		if (now < next->watch.due) {
+			uint64_t remaining = next->watch.due - now;
+			struct timespec deadline;
+			clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_sec += (time_t)(remaining / 1000000000);
+			deadline.tv_nsec += (long)(remaining % 1000000000);
+			if (deadline.tv_nsec >= 1000000000) deadline.tv_sec++, deadline.tv_nsec -= 1000000000;
+			pthread_cond_timedwait(&__watchdog.condition, &__watchdog.mutex, &deadline);
+			continue;
+		}
+		
+		/* WDOperationQueueDealloc() waits for the end of the check */
+		LIST_REMOVE(next, watch.queues);
+		next->watch.armed = 0;
+		__watchdog.inspecting = next;
+		pthread_mutex_unlock(&__watchdog.mutex);
+		pthread_mutex_lock(&next->guard.mutex);
+		WDOperationQueueGrowIfNeeded(next);
+		pthread_mutex_unlock(&next->guard.mutex);
+		pthread_mutex_lock(&__watchdog.mutex);
+		__watchdog.inspecting = NULL;
+		pthread_cond_broadcast(&__watchdog.condition);
+	}
+	return (void *)NULL;
+}
+
+static inline size_t __indexBucket(const struct _wd_operation_queue_index_t *index, uint64_t key) {
+	/* Fibonacci hashing, the capacity is always a power of two */
+	return (size_t)((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (index->capacity - 1);
+}
+
+static struct _list_item *__indexFind(struct _wd_operation_queue_index_t *index, uint64_t key) {
+	if (index->count == 0) return NULL;
+	struct _list_item *item;
+	LIST_FOREACH(item, &index->buckets[__indexBucket(index, key)], bucket) {
+		if (item->key == key) return item;
+	}
+	return NULL;
+}
+
+static int __indexInsert(struct _wd_operation_queue_index_t *index, struct _list_item *item) {
+	/* Keep the load factor under 1 */
+	if (index->count >= index->capacity) {
+		size_t capacity = index->capacity ? index->capacity * 2 : WDOperationQueueIndexInitialCapacity;
+		struct BucketHead *buckets = calloc(capacity, sizeof(struct BucketHead));
+		if (NULL == buckets) return errno = ENOMEM, -WDOperationQueueResultFailure;
+		struct _wd_operation_queue_index_t grown = { buckets, capacity, index->count };
+		for (size_t i=0; i<index->capacity; i++) {
+			struct _list_item *moved;
+			while ((moved = LIST_FIRST(&index->buckets[i])) != NULL) {
+				LIST_REMOVE(moved, bucket);
+				LIST_INSERT_HEAD(&grown.buckets[__indexBucket(&grown, moved->key)], moved, bucket);
+			}
+		}
+		free(index->buckets);
+		*index = grown;
+	}
+	LIST_INSERT_HEAD(&index->buckets[__indexBucket(index, item->key)], item, bucket);
+	item->keyed = 1;
+	index->count++;
+	return WDOperationQueueResultSuccess;
+}
+
+static void __indexRemove(struct _wd_operation_queue_index_t *index, struct _list_item *item) {
+	if (!item->keyed) return;
+	LIST_REMOVE(item, bucket);
+	item->keyed = 0;
+	index->count--;
+}
+
+static inline int __heapBefore(const struct _list_item *a, const struct _list_item *b) {
+	return a->deadline < b->deadline || (a->deadline == b->deadline && a->sequence < b->sequence);
+}
+
+static inline void __heapPlace(struct _wd_operation_queue_schedule_t *schedule, struct _list_item *item, size_t index) {
+	schedule->heap[index] = item;
+	item->heapIndex = index;
+}
+
+static void __heapSiftUp(struct _wd_operation_queue_schedule_t *schedule, size_t index) {
+	struct _list_item *item = schedule->heap[index];
+	while (index > 0) {
+		size_t parent = (index - 1) / 2;
+		if (!__heapBefore(item, schedule->heap[parent])) break;
+		__heapPlace(schedule, schedule->heap[parent], index);
+		index = parent;
+	}
+	__heapPlace(schedule, item, index);
+}
+
+static void __heapSiftDown(struct _wd_operation_queue_schedule_t *schedule, size_t index) {
+	struct _list_item *item = schedule->heap[index];
+	for (;;) {
+		size_t child = 2 * index + 1;
+		if (child >= schedule->count) break;
+		if (child + 1 < schedule->count && __heapBefore(schedule->heap[child + 1], schedule->heap[child])) child++;
+		if (!__heapBefore(schedule->heap[child], item)) break;
+		__heapPlace(schedule, schedule->heap[child], index);
+		index = child;
+	}
+	__heapPlace(schedule, item, index);
+}
+
+static int __heapInsert(struct _wd_operation_queue_schedule_t *schedule, struct _list_item *item) {
+	if (schedule->count == schedule->capacity) {
+		size_t capacity = schedule->capacity ? schedule->capacity * 2 : WDOperationQueueHeapInitialCapacity;
+		struct _list_item **heap = realloc(schedule->heap, capacity * sizeof(struct _list_item *));
+		if (NULL == heap) return errno = ENOMEM, -WDOperationQueueResultFailure;
+		schedule->heap = heap;
+		schedule->capacity = capacity;
+	}
+	__heapPlace(schedule, item, schedule->count++);
+	__heapSiftUp(schedule, item->heapIndex);
+	return WDOperationQueueResultSuccess;
+}
+
+static void __heapRemove(struct _wd_operation_queue_schedule_t *schedule, struct _list_item *item) {
+	size_t index = item->heapIndex;
+	struct _list_item *last = schedule->heap[--schedule->count];
+	if (last == item) return;
+	__heapPlace(schedule, last, index);
+	__heapSiftUp(schedule, index);
+	__heapSiftDown(schedule, last->heapIndex);
+}
+
+static WDOperation *__pendingRemove(WDOperationQueue *queue, struct _list_item *item) {
+	if (queue->schedule.scheduling == WDOperationQueueSchedulingEDF)
+		__heapRemove(&queue->schedule, item);
+	TAILQ_REMOVE(&(queue->operations), item, items);
+	__indexRemove(&queue->index, item);
+	WDOperation *operation = (WDOperation *) item->operation;
+	operation->item = NULL;
+	release(item);
+	return operation;
+}
+
+int WDOperationQueueEnqueue(WDOperationQueue *restrict queue, WDOperation *restrict operation, int keyed, uint64_t key, wd_operation_merge_f merge) {
 	if ( queue == NULL ) return errno = EINVAL, -WDOperationQueueResultFailure;
 	if ( operation == NULL ) return errno = EINVAL, -WDOperationQueueResultFailure;
 	if ( operation->queuef == NULL ) return errno = EINVAL, -WDOperationQueueResultFailure;
@@ -220,95 +694,183 @@ int WDOperationQueueAddOperation(WDOperationQueue *restrict queue, WDOperation *
 	/* If the queu is already on another queue */
 	pthread_mutex_lock(&operation->guard.mutex);
 	if (operation->queue) return pthread_mutex_unlock(&(queue->guard.mutex)), pthread_mutex_unlock(&operation->guard.mutex), errno = EINVAL, -WDOperationQueueResultFailure;
+	uint64_t deadline = operation->deadline ? operation->deadline : UINT64_MAX;
 	pthread_mutex_unlock(&operation->guard.mutex);
 	
 	/* if it was already executed */
-	pthread_mutex_unlock(&operation->wait.mutex);
-	if (operation->flags.finished)
+	pthread_mutex_lock(&operation->wait.mutex);
+	if (__operationFlags(operation) & WDOperationFlagFinished)
 		return pthread_mutex_unlock(&(queue->guard.mutex)), pthread_mutex_unlock(&operation->wait.mutex), errno = EINVAL, -WDOperationQueueResultFailure;
 	pthread_mutex_unlock(&operation->wait.mutex);
 	
-	int wasEmpty = TAILQ_EMPTY(&queue->operations);
+	/* Coalesce with a pending operation having the same key */
+	struct _list_item *pending = keyed ? __indexFind(&queue->index, key) : NULL;
+	if (NULL != pending) {
+		pthread_mutex_lock(&pending->operation->guard.mutex);
+		int canceled = __operationFlags(pending->operation) & WDOperationFlagCanceled;
+		pthread_mutex_unlock(&pending->operation->guard.mutex);
+		/* A canceled operation will never run and an expired one is left to the miss policy, the new one takes its place in the index */
+		if (canceled || (pending->deadline != UINT64_MAX && __now() > pending->deadline))
+			__indexRemove(&queue->index, pending);
+		else {
+			if (NULL != merge)
+				merge(pending->operation->argument, operation->argument);
+			/* The merged work is due as soon as the most urgent of both */
+			if (deadline < pending->deadline) {
+				pending->deadline = deadline;
+				pthread_mutex_lock(&pending->operation->guard.mutex);
+				pending->operation->deadline = deadline;
+				pthread_mutex_unlock(&pending->operation->guard.mutex);
+				if (queue->schedule.scheduling == WDOperationQueueSchedulingEDF)
+					__heapSiftUp(&queue->schedule, pending->heapIndex);
+			}
+			queue->coalesced++;
+			pthread_mutex_unlock(&(queue->guard.mutex));
+			
+			/* The incoming operation will never run, release anyone waiting on it */
+			WDOperationCancel(operation);
+			WDOperationFinish(operation);
+			return WDOperationQueueResultCoalesced;
+		}
+	}
+	
 	struct _list_item *item = MEMORY_MANAGEMENT_ALLOC(sizeof(struct _list_item));
 	if ( item == NULL ) return pthread_mutex_unlock(&(queue->guard.mutex)), errno = ENOMEM, -WDOperationQueueResultFailure;
+	item->key = key;
+	item->enqueued = __now();
+	item->deadline = deadline;
+	item->sequence = queue->schedule.sequence++;
+	if (queue->schedule.scheduling == WDOperationQueueSchedulingEDF && __heapInsert(&queue->schedule, item) != WDOperationQueueResultSuccess)
+		return pthread_mutex_unlock(&(queue->guard.mutex)), release(item), errno = ENOMEM, -WDOperationQueueResultFailure;
+	if (keyed && __indexInsert(&queue->index, item) != WDOperationQueueResultSuccess) {
+		if (queue->schedule.scheduling == WDOperationQueueSchedulingEDF) __heapRemove(&queue->schedule, item);
+		return pthread_mutex_unlock(&(queue->guard.mutex)), release(item), errno = ENOMEM, -WDOperationQueueResultFailure;
+	}
 	
 	/* Add the operation to the queue */
 	item->operation = retain(operation);
 	TAILQ_INSERT_TAIL(&(queue->operations), item, items);
 	pthread_mutex_lock(&operation->guard.mutex);
 	operation->queue = queue;
+	operation->item = item;
 	pthread_mutex_unlock(&operation->guard.mutex);
 	
-	/* Inform that the queue is no more empty */
-	if (wasEmpty) pthread_cond_signal(&queue->guard.condition);
+	/* Inform that the queue is no more empty or add a worker if every one is busy */
+	if (queue->pool.idle > 0) pthread_cond_signal(&queue->guard.condition);
+	else WDOperationQueueGrowIfNeeded(queue);
 	
 	pthread_mutex_unlock(&(queue->guard.mutex));
 	return WDOperationQueueResultSuccess;
 }
 
+int WDOperationQueueAddOperation(WDOperationQueue *restrict queue, WDOperation *restrict operation) {
+	return WDOperationQueueEnqueue(queue, operation, 0, 0, NULL);
+}
+
+int WDOperationQueueAddOperationWithKey(WDOperationQueue *restrict queue, WDOperation *restrict operation, uint64_t key, wd_operation_merge_f merge) {
+	return WDOperationQueueEnqueue(queue, operation, 1, key, merge);
+}
+
+int WDOperationQueueSetScheduling(WDOperationQueue *queue, wd_operation_queue_scheduling_t scheduling) {
+	if (NULL == queue) return errno = EINVAL, -WDOperationQueueResultFailure;
+	if (scheduling != WDOperationQueueSchedulingFIFO && scheduling != WDOperationQueueSchedulingEDF) return errno = EINVAL, -WDOperationQueueResultFailure;
+	
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (scheduling != queue->schedule.scheduling) {
+		queue->schedule.count = 0;
+		/* Order the pending operations by deadline */
+		if (scheduling == WDOperationQueueSchedulingEDF) {
+			struct _list_item *item;
+			TAILQ_FOREACH(item, &queue->operations, items) {
+				if (__heapInsert(&queue->schedule, item) != WDOperationQueueResultSuccess)
+					return queue->schedule.count = 0, pthread_mutex_unlock(&queue->guard.mutex), -WDOperationQueueResultFailure;
+			}
+		}
+		queue->schedule.scheduling = scheduling;
+	}
+	pthread_mutex_unlock(&queue->guard.mutex);
+	return WDOperationQueueResultSuccess;
+}
+
+void WDOperationQueueSetDeadlineMissPolicy(WDOperationQueue *queue, wd_operation_queue_deadline_miss_t policy) {
+	if (NULL == queue) { errno = EINVAL; return; }
+	pthread_mutex_lock(&queue->guard.mutex);
+	queue->schedule.missPolicy = policy;
+	pthread_mutex_unlock(&queue->guard.mutex);
+}
+
+int WDOperationQueueGetStatistics(WDOperationQueue *queue, wd_operation_queue_statistics_t *statistics) {
+	if (NULL == queue || NULL == statistics) return errno = EINVAL, -WDOperationQueueResultFailure;
+	pthread_mutex_lock(&queue->guard.mutex);
+	*statistics = (wd_operation_queue_statistics_t){ queue->counters.executed, queue->coalesced, queue->counters.deadlinesMet, queue->counters.deadlinesMissed, queue->counters.expired };
+	pthread_mutex_unlock(&queue->guard.mutex);
+	return WDOperationQueueResultSuccess;
+}
+
 void WDOperationQueueSuspend(WDOperationQueue *restrict queue, int choice) {
 	if (NULL == queue) return;
 	/* Cannot suspend the main queue */
 	if (queue == &__mainQueue) return;
 	if (choice < 0) return;
 	
-	pthread_mutex_lock(&queue->suspend.mutex);
-	if (choice != queue->flags.suspend) {
-		if (choice > 0)
-			queue->flags.suspend = 1;
-		else {
-			unsigned int wasSuspened = queue->flags.suspend;
-			queue->flags.suspend = 0;
-			if (wasSuspened)
-				pthread_cond_signal(&queue->suspend.condition);
-		}
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (choice > 0)
+		__atomic_store_n(&queue->flags.suspend, 1, __ATOMIC_RELEASE);
+	else if (queue->flags.suspend) {
+		__atomic_store_n(&queue->flags.suspend, 0, __ATOMIC_RELEASE);
+		pthread_cond_broadcast(&queue->guard.condition);
+		WDOperationQueueGrowIfNeeded(queue);
 	}
-	
-	pthread_mutex_unlock(&queue->suspend.mutex);
+	pthread_mutex_unlock(&queue->guard.mutex);
 }
 
 int WDOperationQueueIsSuspended(WDOperationQueue *restrict queue) {
 	if (NULL == queue) return errno = EINVAL, -WDOperationQueueResultFailure;
-	return queue->flags.suspend;
+	return __atomic_load_n(&queue->flags.suspend, __ATOMIC_ACQUIRE);
 }
 
 WDOperation *WDOperationQueuePopOperation(WDOperationQueue *restrict queue) {
 	if (queue == NULL) return errno = EINVAL, NULL;
 	
-	pthread_mutex_lock(&(queue->guard.mutex));
-	WDOperation *operation = NULL;
-	
-	int isEmpty = TAILQ_EMPTY(&queue->operations);
-	/* Block if there is no operation in the queue */
-	if (isEmpty) {
-		pthread_cond_wait(&queue->guard.condition, &queue->guard.mutex);
-		isEmpty = TAILQ_EMPTY(&queue->operations);
-		/* If the queue is still empty then the operation queue was stopped see WDOperationQueueDealloc() */
-		if (isEmpty) return pthread_mutex_unlock(&(queue->guard.mutex)), (WDOperation *)NULL;
-	}
-	/* If it was signaled and the queue is suspended it should*/
-	pthread_mutex_lock(&queue->suspend.mutex);
-	if (queue->flags.suspend)
-		return pthread_mutex_unlock(&queue->suspend.mutex), pthread_mutex_unlock(&(queue->guard.mutex)), NULL;
-	pthread_mutex_unlock(&queue->suspend.mutex);
-	
-	/* Remove the operation from the internal list */
+	/* Remove the operation from the internal list, the caller holds `guard.mutex` */
 	struct _list_item *item = TAILQ_FIRST(&queue->operations);
-	if ( item == NULL ) return pthread_mutex_unlock(&(queue->guard.mutex)), (WDOperation *)NULL;
-	operation = (WDOperation *) item->operation;
-	TAILQ_REMOVE(&(queue->operations), item, items);
-	release(item);
+	if ( item == NULL ) return (WDOperation *)NULL;
+	/* Earliest deadline first */
+	if (queue->schedule.scheduling == WDOperationQueueSchedulingEDF)
+		item = queue->schedule.heap[0];
 	
-	pthread_mutex_unlock(&(queue->guard.mutex));
 	/* Return the operation */
-	return operation;
+	return __pendingRemove(queue, item);
 }
 
-void WDOperationQueuePopAndPerform(WDOperationQueue *restrict queue) {
-	if (queue == NULL) { errno = EINVAL; return; }
-	WDOperation *operation = WDOperationQueuePopOperation(queue);
-	WDOperationPerform(operation);
-	release(operation);
+int WDOperationQueueHelp(struct _wd_operation_queue_worker_t *worker, WDOperation *operation) {
+	WDOperationQueue *queue = worker->queue;
+	pthread_mutex_lock(&queue->guard.mutex);
+	while (!queue->flags.stop && !queue->flags.suspend) {
+		pthread_mutex_lock(&operation->wait.mutex);
+		int finished = __operationFlags(operation) & WDOperationFlagFinished;
+		pthread_mutex_unlock(&operation->wait.mutex);
+		if (finished) return pthread_mutex_unlock(&queue->guard.mutex), 0;
+		
+		/* Run the awaited operation inline if it is pending on this queue */
+		pthread_mutex_lock(&operation->guard.mutex);
+		struct _list_item *item = (operation->queue == queue) ? operation->item : NULL;
+		pthread_mutex_unlock(&operation->guard.mutex);
+		if (NULL != item)
+			WDOperationQueueExecute(worker, __pendingRemove(queue, item));
+		/* Otherwise run other pending operations while it executes elsewhere */
+		else if (!TAILQ_EMPTY(&queue->operations))
+			WDOperationQueueExecute(worker, WDOperationQueuePopOperation(queue));
+		else
+			break;
+	}
+	/* Nothing to help with, let the pool replace the worker while it blocks */
+	if (worker->blocking++ == 0) {
+		queue->pool.blocked++;
+		WDOperationQueueGrowIfNeeded(queue);
+	}
+	pthread_mutex_unlock(&queue->guard.mutex);
+	return 1;
 }
 
 void WDOperationQueueCancelAllOperations(WDOperationQueue *queue) {
@@ -318,7 +880,7 @@ void WDOperationQueueCancelAllOperations(WDOperationQueue *queue) {
 	
 	struct _list_item *item;
 	TAILQ_FOREACH(item, &queue->operations, items) {
-		item->operation->flags.canceled = 1;
+		__operationSetFlags(item->operation, WDOperationFlagCanceled);
 	}
 	
 	pthread_mutex_unlock(&queue->guard.mutex);
@@ -326,10 +888,37 @@ void WDOperationQueueCancelAllOperations(WDOperationQueue *queue) {
 
 void WDOperationQueueWaitAllOperations(WDOperationQueue *queue) {
 	if (NULL == queue) return;
-	while (!TAILQ_EMPTY(&queue->operations)) {
-		struct _list_item *item = TAILQ_LAST(&queue->operations, ListHead);
-		WDOperationWaitUntilFinished(item->operation);
+	pthread_mutex_lock(&queue->guard.mutex);
+	while (!TAILQ_EMPTY(&queue->operations) || queue->pool.executing > 0)
+		pthread_cond_wait(&queue->pool.condition, &queue->guard.mutex);
+	pthread_mutex_unlock(&queue->guard.mutex);
+}
+
+void WDOperationBeginBlocking(WDOperation *operation) {
+	if (NULL == operation) { errno = EINVAL; return; }
+	/* Only the worker executing the operation may declare a blocking section */
+	struct _wd_operation_queue_worker_t *worker = pthread_getspecific(__workerKey);
+	if (NULL == worker || worker->executingOperation != operation) { errno = EINVAL; return; }
+	
+	WDOperationQueue *queue = worker->queue;
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (worker->blocking++ == 0) {
+		queue->pool.blocked++;
+		WDOperationQueueGrowIfNeeded(queue);
 	}
+	pthread_mutex_unlock(&queue->guard.mutex);
+}
+
+void WDOperationEndBlocking(WDOperation *operation) {
+	if (NULL == operation) { errno = EINVAL; return; }
+	struct _wd_operation_queue_worker_t *worker = pthread_getspecific(__workerKey);
+	if (NULL == worker || worker->executingOperation != operation || worker->blocking == 0) { errno = EINVAL; return; }
+	
+	WDOperationQueue *queue = worker->queue;
+	pthread_mutex_lock(&queue->guard.mutex);
+	if (--worker->blocking == 0)
+		queue->pool.blocked--;
+	pthread_mutex_unlock(&queue->guard.mutex);
 }
 
 
@@ -348,7 +937,6 @@ WDOperation *WDOperationCreate(const wd_operation_f function, void *restrict arg
 	pthread_mutex_init(&operation->wait.mutex, NULL);
 	pthread_cond_init(&operation->wait.condition, NULL);
 	pthread_mutex_init(&operation->guard.mutex, NULL);
-	pthread_cond_init(&operation->guard.condition, NULL);
 	
 	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(operation, WDOperationDealloc);
 	return operation;
@@ -360,7 +948,6 @@ void WDOperationDealloc(void *_operation) {
 	pthread_mutex_destroy(&operation->wait.mutex);
 	pthread_cond_destroy(&operation->wait.condition);
 	pthread_mutex_destroy(&operation->guard.mutex);
-	pthread_cond_destroy(&operation->guard.condition);
 	
 	release((void *)operation->argument);
 }
@@ -375,35 +962,33 @@ void WDOperationRelease(WDOperation *operation) {
 	release(operation);
 }
 
-void WDOperationPerform(WDOperation *restrict operation) {
-	if ( operation == NULL ) return;
-	if ( operation->queuef == NULL ) return;
+int WDOperationPerform(WDOperation *restrict operation) {
+	if ( operation == NULL ) return 0;
+	if ( operation->queuef == NULL ) return 0;
 	
-	pthread_mutex_lock(&operation->guard.mutex);
 	/* If the operation was not canceled */
-	if (!operation->flags.canceled) {
+	int executed = !(__operationFlags(operation) & WDOperationFlagCanceled);
+	if (executed) {
 		/* Indicate that it is executing */
-		operation->flags.executing = 1;
-		/* Associate the operation to the operation queue's executing operation */
-		operation->queue->executingOperation = retain(operation);
+		__operationSetFlags(operation, WDOperationFlagExecuting);
 		/* Execute the operation with its argument */
-		pthread_mutex_unlock(&operation->guard.mutex);
 		operation->queuef(operation, (void *)operation->argument);
-		pthread_mutex_lock(&operation->guard.mutex);
 		/* Indicate that the operation is not executing any more */
-		operation->flags.executing = 0;
+		__operationClearFlags(operation, WDOperationFlagExecuting);
 		/* Disassociate the operation from the queue */
-		operation->queue->executingOperation = NULL;
-		release(operation);
+		pthread_mutex_lock(&operation->guard.mutex);
 		operation->queue = NULL;
+		pthread_mutex_unlock(&operation->guard.mutex);
 	}
-	pthread_mutex_unlock(&operation->guard.mutex);
-	
 	
+	WDOperationFinish(operation);
+	return executed;
+}
 
+void WDOperationFinish(WDOperation *restrict operation) {
 	pthread_mutex_lock(&operation->wait.mutex);
 	/* Mark the operation as finished */
-	operation->flags.finished = 1;
+	__operationSetFlags(operation, WDOperationFlagFinished);
 	/* Inform any one waiting in WDOperationWaitUntilFinished() call */
 	pthread_cond_broadcast(&operation->wait.condition);
 	pthread_mutex_unlock(&operation->wait.mutex);
@@ -419,25 +1004,51 @@ WDOperationQueue *WDOperationCurrentOperationQueue(WDOperation *operation) {
 
 void WDOperationCancel(WDOperation *operation) {
 	if (NULL == operation) { errno = EINVAL; return; }
+	__operationSetFlags(operation, WDOperationFlagCanceled);
+}
+
+int WDOperationSetDeadline(WDOperation *operation, const struct timespec *deadline) {
+	if (NULL == operation) return errno = EINVAL, -WDOperationQueueResultFailure;
 	pthread_mutex_lock(&operation->guard.mutex);
-	operation->flags.canceled = 1;
+	/* The deadline orders the pending operations, it cannot change once added to a queue */
+	if (operation->queue) return pthread_mutex_unlock(&operation->guard.mutex), errno = EBUSY, -WDOperationQueueResultFailure;
+	operation->deadline = (NULL == deadline) ? 0 : (uint64_t)deadline->tv_sec * 1000000000 + (uint64_t)deadline->tv_nsec;
 	pthread_mutex_unlock(&operation->guard.mutex);
+	return WDOperationQueueResultSuccess;
 }
 
 wd_operation_flags_t WDOperationGetFlags(WDOperation *operation) {
 	wd_operation_flags_t flags = { 0, 0, 0 };
 	if (NULL == operation) return errno = EINVAL, flags;
-	flags = operation->flags;
+	unsigned int bits = __operationFlags(operation);
+	flags.canceled = (bits & WDOperationFlagCanceled) != 0;
+	flags.finished = (bits & WDOperationFlagFinished) != 0;
+	flags.executing = (bits & WDOperationFlagExecuting) != 0;
 	return flags;
 }
 
 void WDOperationWaitUntilFinished(WDOperation *operation) {
 	if (NULL == operation) return;
+	if (__operationFlags(operation) & WDOperationFlagFinished) return;
+	/* Helping may execute the operation and drop the last reference of its queue */
+	retain(operation);
+	/* From within a worker help with the pending operations instead of blocking the worker */
+	struct _wd_operation_queue_worker_t *worker = pthread_getspecific(__workerKey);
+	int blocking = (NULL != worker && worker->executingOperation != operation) ? WDOperationQueueHelp(worker, operation) : 0;
+	
 	pthread_mutex_lock(&operation->wait.mutex);
 	/* Block if the operaiton is not finished */
-	if (!operation->flags.finished)
+	while (!(__operationFlags(operation) & WDOperationFlagFinished))
 		pthread_cond_wait(&operation->wait.condition, &operation->wait.mutex);
 	pthread_mutex_unlock(&operation->wait.mutex);
+	
+	if (blocking) {
+		pthread_mutex_lock(&worker->queue->guard.mutex);
+		if (--worker->blocking == 0)
+			worker->queue->pool.blocked--;
+		pthread_mutex_unlock(&worker->queue->guard.mutex);
+	}
+	release(operation);
 }
 
 
@@ -446,7 +1057,12 @@ WDOperationQueue *WDOperationQueueMainQueue() {
 }
 
 int WDOperationQueueMainQueueLoop() {
-	WDOperationQueueThreadF(&__mainQueue);
+	struct _wd_operation_queue_worker_t worker = { pthread_self(), &__mainQueue, NULL, 0, { NULL, NULL } };
+	pthread_mutex_lock(&__mainQueue.guard.mutex);
+	LIST_INSERT_HEAD(&__mainQueue.pool.active, &worker, workers);
+	__mainQueue.pool.count++;
+	pthread_mutex_unlock(&__mainQueue.guard.mutex);
+	WDOperationQueueThreadF(&worker);
 	return WDOperationQueueResultSuccess;
 }
 
@@ -0,0 +1,421 @@
+/*!
+ *  @file pipeline.c
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+
+#include <memory_management/memory_management.h>
+#include "pipeline.h"
+
+#define WDPipelineResultSuccess 0
+#define WDPipelineResultFailure 1
+
+#define WDPipelineDefaultBatchSize 64
+#define WDPipelineDefaultFlushLatency 1000 /* microseconds */
+#define WDPipelineStagesInitialCapacity 4
+
+#define WDCacheLineSize 64
+
+void WDPipelineDealloc(void *pipeline) __attribute__((visibility("internal")));
+void WDPipelineStageDealloc(void *stage) __attribute__((visibility("internal")));
+void WDPipelineDrain(WDOperation *operation, void *stage) __attribute__((visibility("internal")));
+void *WDPipelineFlushThreadF(void *pipeline) __attribute__((visibility("internal")));
+
+struct _wd_pipeline_slot_t {
+	void *item;
+	uint64_t enqueued; /*!< the monotonic time in nanoseconds the item was pushed to the ring */
+};
+
+/*!
+ *  @struct _wd_pipeline_stage_t
+ *  @brief A pipeline stage and the ring in front of it.
+ *  @ingroup wd
+ *	@details The producer of the ring is the thread pushing the items for the first stage and the previous stage otherwise, the consumer is the stage. A stage is executed by at most one operation at any time, so each ring has a single producer and a single consumer.
+ */
+struct _wd_pipeline_stage_t {
+	struct _wd_pipeline_ring_t {
+		size_t tail; /*!< the next slot to fill, written only by the producer */
+		char producerPadding[WDCacheLineSize];
+		size_t head; /*!< the next slot to consume, written only by the consumer */
+		char consumerPadding[WDCacheLineSize];
+		struct _wd_pipeline_slot_t *slots;
+		size_t mask; /*!< the capacity of the ring minus one */
+	} ring; /*!< the items waiting for the stage */
+
+	wd_pipeline_stage_f function;
+	void *context;
+	WDOperationQueue *queue;
+	WDPipeline *pipeline;
+	unsigned int index;
+	int scheduled; /*!< whether a drain operation is pending or executing, only accessed atomically */
+
+	wd_pipeline_stage_statistics_t statistics; /*!< written by the drain operations, only accessed atomically */
+};
+
+/*!
+ *  @struct _wd_pipeline_t
+ *  @brief The pipeline structure.
+ *  @ingroup wd
+ */
+struct _wd_pipeline_t {
+	struct _wd_pipeline_stage_t **stages; /*!< the stages, managed objects retained by their drain operations */
+	unsigned int count;
+	unsigned int capacity;
+	size_t batchSize;
+	unsigned int flushLatency; /*!< microseconds */
+	int started;
+	uint64_t pushed; /*!< written only by the producer, only accessed atomically */
+
+	struct _wd_pipeline_wait_t {
+		pthread_mutex_t mutex;
+		pthread_cond_t condition; /*!< signaled when a drain operation finishes */
+		uint64_t completed; /*!< the items that left the pipeline */
+		unsigned long active; /*!< the drain operations pending or executing */
+	} wait; /*!< the associated data for use with @ref WDPipelineWaitAllItems, protected by `wait.mutex` */
+
+	struct _wd_pipeline_flusher_t {
+		pthread_t thread;
+		pthread_cond_t condition; /*!< signaled to stop the thread or when the first stage stops being empty, used with `wait.mutex` */
+		int running;
+		int stop;
+		int sleeping; /*!< whether the thread waits for the first stage to stop being empty, set under `wait.mutex` and only accessed atomically */
+	} flusher; /*!< the thread flushing the incomplete batches */
+};
+
+static inline uint64_t __now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+}
+
+static inline size_t __ringCount(struct _wd_pipeline_ring_t *restrict ring) {
+	return __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) - __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+}
+
+static inline size_t __ringFree(struct _wd_pipeline_ring_t *restrict ring) {
+	return ring->mask + 1 - __ringCount(ring);
+}
+
+static inline void __statisticsAdd(uint64_t *counter, uint64_t value) {
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+static inline struct _wd_pipeline_stage_t *__nextStage(struct _wd_pipeline_stage_t *restrict stage) {
+	WDPipeline *pipeline = stage->pipeline;
+	return stage->index + 1 < pipeline->count ? pipeline->stages[stage->index + 1] : NULL;
+}
+
+static int __stageCanProgress(struct _wd_pipeline_stage_t *restrict stage) {
+	struct _wd_pipeline_stage_t *next = __nextStage(stage);
+	return __ringCount(&stage->ring) > 0 && (NULL == next || __ringFree(&next->ring) > 0);
+}
+
+/* Schedules a drain operation unless one is already pending or executing */
+static void __stageWake(struct _wd_pipeline_stage_t *restrict stage) {
+	WDPipeline *pipeline = stage->pipeline;
+	int expected = 0;
+	if (!__stageCanProgress(stage) || !__atomic_compare_exchange_n(&stage->scheduled, &expected, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		return;
+
+	pthread_mutex_lock(&pipeline->wait.mutex);
+	pipeline->wait.active++;
+	pthread_mutex_unlock(&pipeline->wait.mutex);
+
+	WDOperation *operation = WDOperationCreate(WDPipelineDrain, stage);
+	int result = (NULL != operation) ? WDOperationQueueAddOperation(stage->queue, operation) : -WDPipelineResultFailure;
+	release(operation);
+	if (result >= 0)
+		return;
+
+	/* The stage is woken again by the next batch or flush */
+	__atomic_store_n(&stage->scheduled, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_lock(&pipeline->wait.mutex);
+	pipeline->wait.active--;
+	pthread_cond_broadcast(&pipeline->wait.condition);
+	pthread_mutex_unlock(&pipeline->wait.mutex);
+}
+
+WDPipeline *WDPipelineAllocate(void) {
+	WDPipeline *pipeline = MEMORY_MANAGEMENT_ALLOC(sizeof(WDPipeline));
+	if ( pipeline == NULL ) return errno = ENOMEM, (WDPipeline *)NULL;
+
+	pipeline->batchSize = WDPipelineDefaultBatchSize;
+	pipeline->flushLatency = WDPipelineDefaultFlushLatency;
+	pthread_mutex_init(&pipeline->wait.mutex, NULL);
+	pthread_cond_init(&pipeline->wait.condition, NULL);
+	pthread_cond_init(&pipeline->flusher.condition, NULL);
+	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(pipeline, WDPipelineDealloc);
+	return pipeline;
+}
+
+void WDPipelineDealloc(void *_pipeline) {
+	if (NULL == _pipeline) return;
+	WDPipeline *pipeline = _pipeline;
+
+	if (pipeline->started) {
+		if (pipeline->flusher.running) {
+			pthread_mutex_lock(&pipeline->wait.mutex);
+			pipeline->flusher.stop = 1;
+			pthread_cond_signal(&pipeline->flusher.condition);
+			pthread_mutex_unlock(&pipeline->wait.mutex);
+			pthread_join(pipeline->flusher.thread, NULL);
+		}
+		/* Every pushed item leaves the pipeline and no drain operation refers to it any more */
+		WDPipelineWaitAllItems(pipeline);
+	}
+
+	for (unsigned int i=0; i<pipeline->count; i++)
+		release(pipeline->stages[i]);
+	free(pipeline->stages);
+	pthread_mutex_destroy(&pipeline->wait.mutex);
+	pthread_cond_destroy(&pipeline->wait.condition);
+	pthread_cond_destroy(&pipeline->flusher.condition);
+}
+
+void WDPipelineStageDealloc(void *_stage) {
+	if (NULL == _stage) return;
+	struct _wd_pipeline_stage_t *stage = _stage;
+	release(stage->queue);
+	free(stage->ring.slots);
+}
+
+WDPipeline *WDPipelineRetain(WDPipeline *pipeline) {
+	return retain(pipeline);
+}
+
+void WDPipelineRelease(WDPipeline *pipeline) {
+	release(pipeline);
+}
+
+int WDPipelineAddStage(WDPipeline *pipeline, WDOperationQueue *queue, wd_pipeline_stage_f function, void *context, size_t capacity) {
+	if (NULL == pipeline || NULL == queue || NULL == function || 0 == capacity)
+		return errno = EINVAL, -WDPipelineResultFailure;
+	if (pipeline->started)
+		return errno = EBUSY, -WDPipelineResultFailure;
+
+	if (pipeline->count == pipeline->capacity) {
+		unsigned int stagesCapacity = pipeline->capacity ? pipeline->capacity * 2 : WDPipelineStagesInitialCapacity;
+		struct _wd_pipeline_stage_t **stages = realloc(pipeline->stages, stagesCapacity * sizeof(struct _wd_pipeline_stage_t *));
+		if (NULL == stages)
+			return errno = ENOMEM, -WDPipelineResultFailure;
+		pipeline->stages = stages;
+		pipeline->capacity = stagesCapacity;
+	}
+
+	size_t slots = 1;
+	while (slots < capacity)
+		slots <<= 1;
+	struct _wd_pipeline_stage_t *stage = MEMORY_MANAGEMENT_ALLOC(sizeof(struct _wd_pipeline_stage_t));
+	if (NULL == stage)
+		return errno = ENOMEM, -WDPipelineResultFailure;
+	stage->ring.slots = calloc(slots, sizeof(struct _wd_pipeline_slot_t));
+	if (NULL == stage->ring.slots)
+		return release(stage), errno = ENOMEM, -WDPipelineResultFailure;
+	stage->ring.mask = slots - 1;
+	stage->function = function;
+	stage->context = context;
+	stage->queue = retain(queue);
+	stage->pipeline = pipeline;
+	stage->index = pipeline->count;
+	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(stage, WDPipelineStageDealloc);
+
+	pipeline->stages[pipeline->count] = stage;
+	return (int)pipeline->count++;
+}
+
+int WDPipelineSetBatchSize(WDPipeline *pipeline, size_t batchSize) {
+	if (NULL == pipeline || 0 == batchSize)
+		return errno = EINVAL, -WDPipelineResultFailure;
+	if (pipeline->started)
+		return errno = EBUSY, -WDPipelineResultFailure;
+	pipeline->batchSize = batchSize;
+	return WDPipelineResultSuccess;
+}
+
+int WDPipelineSetFlushLatency(WDPipeline *pipeline, unsigned int microseconds) {
+	if (NULL == pipeline)
+		return errno = EINVAL, -WDPipelineResultFailure;
+	if (pipeline->started)
+		return errno = EBUSY, -WDPipelineResultFailure;
+	pipeline->flushLatency = microseconds;
+	return WDPipelineResultSuccess;
+}
+
+int WDPipelineStart(WDPipeline *pipeline) {
+	if (NULL == pipeline || 0 == pipeline->count)
+		return errno = EINVAL, -WDPipelineResultFailure;
+	if (pipeline->started)
+		return errno = EBUSY, -WDPipelineResultFailure;
+
+	if (pipeline->flushLatency > 0 && pipeline->batchSize > 1) {
+		int error = pthread_create(&pipeline->flusher.thread, NULL, WDPipelineFlushThreadF, pipeline);
+		if (0 != error)
+			return errno = error, -WDPipelineResultFailure;
+		pipeline->flusher.running = 1;
+	}
+	pipeline->started = 1;
+	return WDPipelineResultSuccess;
+}
+
+int WDPipelinePush(WDPipeline *pipeline, void *item) {
+	if (NULL == pipeline || NULL == item || !pipeline->started)
+		return errno = EINVAL, -WDPipelineResultFailure;
+
+	struct _wd_pipeline_stage_t *stage = pipeline->stages[0];
+	struct _wd_pipeline_ring_t *ring = &stage->ring;
+	size_t tail = ring->tail;
+	if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask) {
+		/* Let the first stage make room */
+		__stageWake(stage);
+		return errno = EAGAIN, -WDPipelineResultFailure;
+	}
+
+	ring->slots[tail & ring->mask].item = item;
+	ring->slots[tail & ring->mask].enqueued = __now();
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&pipeline->pushed, pipeline->pushed + 1, __ATOMIC_RELAXED);
+
+	if (tail + 1 - __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) >= pipeline->batchSize)
+		__stageWake(stage);
+	/* The flusher sleeps while the first stage is empty, start its latency */
+	else if (__atomic_load_n(&pipeline->flusher.sleeping, __ATOMIC_SEQ_CST) && __atomic_exchange_n(&pipeline->flusher.sleeping, 0, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&pipeline->wait.mutex);
+		pthread_cond_signal(&pipeline->flusher.condition);
+		pthread_mutex_unlock(&pipeline->wait.mutex);
+	}
+	return WDPipelineResultSuccess;
+}
+
+void WDPipelineFlush(WDPipeline *pipeline) {
+	if (NULL == pipeline || !pipeline->started) return;
+	__stageWake(pipeline->stages[0]);
+}
+
+void WDPipelineWaitAllItems(WDPipeline *pipeline) {
+	if (NULL == pipeline || !pipeline->started) return;
+	uint64_t pushed = __atomic_load_n(&pipeline->pushed, __ATOMIC_RELAXED);
+	WDPipelineFlush(pipeline);
+	pthread_mutex_lock(&pipeline->wait.mutex);
+	while (pipeline->wait.completed < pushed || pipeline->wait.active > 0)
+		pthread_cond_wait(&pipeline->wait.condition, &pipeline->wait.mutex);
+	pthread_mutex_unlock(&pipeline->wait.mutex);
+}
+
+void WDPipelineDrain(WDOperation *operation __attribute__((unused)), void *argument) {
+	struct _wd_pipeline_stage_t *stage = argument;
+	WDPipeline *pipeline = stage->pipeline;
+	struct _wd_pipeline_stage_t *next = __nextStage(stage);
+	struct _wd_pipeline_stage_t *previous = stage->index > 0 ? pipeline->stages[stage->index - 1] : NULL;
+	struct _wd_pipeline_ring_t *ring = &stage->ring;
+	wd_pipeline_stage_statistics_t *statistics = &stage->statistics;
+	uint64_t completed = 0;
+
+	for (;;) {
+		size_t head = ring->head;
+		size_t count = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) - head;
+		if (count > pipeline->batchSize)
+			count = pipeline->batchSize;
+		if (NULL != next && count > __ringFree(&next->ring))
+			count = __ringFree(&next->ring);
+		if (0 == count)
+			break;
+
+		uint64_t started = __now(), delay = 0, maximumDelay = 0;
+		size_t produced = 0, nextTail = NULL != next ? next->ring.tail : 0;
+		for (size_t i=0; i<count; i++) {
+			struct _wd_pipeline_slot_t *slot = &ring->slots[(head + i) & ring->mask];
+			uint64_t waited = started > slot->enqueued ? started - slot->enqueued : 0;
+			delay += waited;
+			if (waited > maximumDelay)
+				maximumDelay = waited;
+			void *item = stage->function(slot->item, stage->context);
+			if (NULL != next && NULL != item)
+				next->ring.slots[(nextTail + produced++) & next->ring.mask].item = item;
+			else
+				completed++;
+		}
+		__atomic_store_n(&ring->head, head + count, __ATOMIC_SEQ_CST);
+
+		uint64_t finished = __now();
+		if (produced > 0) {
+			for (size_t i=0; i<produced; i++)
+				next->ring.slots[(nextTail + i) & next->ring.mask].enqueued = finished;
+			__atomic_store_n(&next->ring.tail, nextTail + produced, __ATOMIC_SEQ_CST);
+			__stageWake(next);
+		}
+		/* Room was made in front of the previous stage */
+		if (NULL != previous)
+			__stageWake(previous);
+
+		__statisticsAdd(&statistics->items, count);
+		__statisticsAdd(&statistics->batches, 1);
+		__statisticsAdd(&statistics->queueingDelay, delay);
+		__statisticsAdd(&statistics->busyTime, finished - started);
+		if (maximumDelay > __atomic_load_n(&statistics->maximumQueueingDelay, __ATOMIC_RELAXED))
+			__atomic_store_n(&statistics->maximumQueueingDelay, maximumDelay, __ATOMIC_RELAXED);
+	}
+
+	/* Items pushed after the last look at the ring must not be left behind */
+	__atomic_store_n(&stage->scheduled, 0, __ATOMIC_SEQ_CST);
+	__stageWake(stage);
+
+	pthread_mutex_lock(&pipeline->wait.mutex);
+	pipeline->wait.completed += completed;
+	pipeline->wait.active--;
+	pthread_cond_broadcast(&pipeline->wait.condition);
+	pthread_mutex_unlock(&pipeline->wait.mutex);
+}
+
+void *WDPipelineFlushThreadF(void *argument) {
+	WDPipeline *pipeline = argument;
+	struct _wd_pipeline_ring_t *ring = &pipeline->stages[0]->ring;
+	pthread_mutex_lock(&pipeline->wait.mutex);
+	while (!pipeline->flusher.stop) {
+		/* Nothing to flush until an item is pushed, the ring is checked again after raising the flag so that a push is never missed */
+		__atomic_store_n(&pipeline->flusher.sleeping, 1, __ATOMIC_SEQ_CST);
+		if (0 == __ringCount(ring)) {
+			pthread_cond_wait(&pipeline->flusher.condition, &pipeline->wait.mutex);
+			__atomic_store_n(&pipeline->flusher.sleeping, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+		__atomic_store_n(&pipeline->flusher.sleeping, 0, __ATOMIC_SEQ_CST);
+
+		/* An incomplete batch is pending, give it the latency to fill up */
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += pipeline->flushLatency / 1000000;
+		deadline.tv_nsec += (long)(pipeline->flushLatency % 1000000) * 1000;
+		if (deadline.tv_nsec >= 1000000000) deadline.tv_sec++, deadline.tv_nsec -= 1000000000;
+		pthread_cond_timedwait(&pipeline->flusher.condition, &pipeline->wait.mutex, &deadline);
+		if (pipeline->flusher.stop)
+			break;
+		pthread_mutex_unlock(&pipeline->wait.mutex);
+		__stageWake(pipeline->stages[0]);
+		pthread_mutex_lock(&pipeline->wait.mutex);
+	}
+	pthread_mutex_unlock(&pipeline->wait.mutex);
+	return NULL;
+}
+
+int WDPipelineGetStageStatistics(WDPipeline *pipeline, unsigned int index, wd_pipeline_stage_statistics_t *statistics) {
+	if (NULL == pipeline || NULL == statistics || index >= pipeline->count)
+		return errno = EINVAL, -WDPipelineResultFailure;
+	struct _wd_pipeline_stage_t *stage = pipeline->stages[index];
+	statistics->items = __atomic_load_n(&stage->statistics.items, __ATOMIC_RELAXED);
+	statistics->batches = __atomic_load_n(&stage->statistics.batches, __ATOMIC_RELAXED);
+	statistics->queueingDelay = __atomic_load_n(&stage->statistics.queueingDelay, __ATOMIC_RELAXED);
+	statistics->maximumQueueingDelay = __atomic_load_n(&stage->statistics.maximumQueueingDelay, __ATOMIC_RELAXED);
+	statistics->busyTime = __atomic_load_n(&stage->statistics.busyTime, __ATOMIC_RELAXED);
+	statistics->pending = __ringCount(&stage->ring);
+	return WDPipelineResultSuccess;
+}
@@ -0,0 +1,422 @@
+/*!
+ *  @file shardedDispatcher.c
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/queue.h>
+#include <errno.h>
+
+#include <memory_management/memory_management.h>
+#include "shardedDispatcher.h"
+
+#define WDShardedDispatcherResultSuccess 0
+#define WDShardedDispatcherResultFailure 1
+
+#define WDShardedDispatcherDefaultRebalanceFactor 4
+#define WDShardedDispatcherRebalanceMinimumBacklog 16 /* functions, below it a lane is never considered hot */
+#define WDShardedDispatcherDrainBudget 64 /* functions executed by a lane before it yields its worker */
+#define WDShardedDispatcherIndexInitialCapacity 16
+
+#define WDCacheLineSize 64
+
+void WDShardedDispatcherDealloc(void *dispatcher) __attribute__((visibility("internal")));
+void WDShardedDispatcherLaneDealloc(void *lane) __attribute__((visibility("internal")));
+void WDShardedDispatcherDrain(WDOperation *operation, void *lane) __attribute__((visibility("internal")));
+
+/*!
+ *  @struct _wd_dispatch_item_t
+ *  @brief A function waiting in a lane.
+ *  @ingroup wd
+ */
+struct _wd_dispatch_item_t {
+	wd_operation_f function;
+	void *argument;
+	uint64_t key;
+	TAILQ_ENTRY(_wd_dispatch_item_t) items;
+};
+
+/*!
+ *  @struct _wd_dispatch_key_t
+ *  @brief The lane of a key that has pending functions.
+ *  @ingroup wd
+ */
+struct _wd_dispatch_key_t {
+	uint64_t key;
+	unsigned int lane; /*!< the lane executing the functions of the key */
+	unsigned long pending; /*!< the functions of the key not finished yet */
+	LIST_ENTRY(_wd_dispatch_key_t) bucket;
+};
+
+/*!
+ *  @struct _wd_dispatch_lane_t
+ *  @brief A serial lane.
+ *  @ingroup wd
+ *	@details At most one operation drains a lane at any time, which is what keeps the functions of a key in order.
+ */
+struct _wd_dispatch_lane_t {
+	pthread_mutex_t mutex;
+	TAILQ_HEAD(ItemHead, _wd_dispatch_item_t) items; /*!< the pending functions, protected by `mutex` */
+	int scheduled; /*!< whether a drain operation is pending or executing, protected by `mutex` */
+	unsigned long backlog; /*!< the functions not finished yet, only accessed atomically */
+	WDShardedDispatcher *dispatcher;
+	char padding[WDCacheLineSize]; /*!< keeps the lanes on distinct cache lines */
+};
+
+/*!
+ *  @struct _wd_dispatch_stripe_t
+ *  @brief A stripe of the index of the keys that have pending functions.
+ *  @ingroup wd
+ *	@details A key belongs to the stripe of the lane its hash designates even when it is executed by another lane, this way a stripe is locked before a lane and never the other way round.
+ */
+struct _wd_dispatch_stripe_t {
+	pthread_mutex_t mutex;
+	LIST_HEAD(KeyHead, _wd_dispatch_key_t) *buckets; /*!< the chains of keys, protected by `mutex` */
+	size_t capacity; /*!< the number of buckets, always a power of two */
+	size_t count; /*!< the number of keys */
+	char padding[WDCacheLineSize]; /*!< keeps the stripes on distinct cache lines */
+};
+
+/*!
+ *  @struct _wd_sharded_dispatcher_t
+ *  @brief The sharded dispatcher structure.
+ *  @ingroup wd
+ */
+struct _wd_sharded_dispatcher_t {
+	WDOperationQueue *queue; /*!< the operation queue whose workers drain the lanes */
+	struct _wd_dispatch_lane_t **lanes; /*!< the lanes, managed objects retained by their drain operations */
+	struct _wd_dispatch_stripe_t *stripes; /*!< one stripe per lane */
+	unsigned int count; /*!< the number of lanes */
+	unsigned int rebalanceFactor;
+	uint64_t rebalanced; /*!< only accessed atomically */
+	struct _wd_sharded_dispatcher_wait_t {
+		pthread_mutex_t mutex;
+		pthread_cond_t condition; /*!< signaled when the backlog of a lane drops to zero while someone waits */
+		unsigned int waiters; /*!< the threads waiting for every lane to be empty, changed under `mutex` and only accessed atomically */
+	} wait; /*!< the associated data for use with @ref WDShardedDispatcherWaitAllFunctions */
+};
+
+static uint64_t __hash(uint64_t key) {
+	key ^= key >> 30;
+	key *= UINT64_C(0xbf58476d1ce4e5b9);
+	key ^= key >> 27;
+	key *= UINT64_C(0x94d049bb133111eb);
+	key ^= key >> 31;
+	return key;
+}
+
+static struct _wd_dispatch_key_t *__stripeFind(struct _wd_dispatch_stripe_t *restrict stripe, uint64_t hash, uint64_t key) {
+	struct _wd_dispatch_key_t *entry;
+	LIST_FOREACH(entry, &stripe->buckets[(hash >> 32) & (stripe->capacity - 1)], bucket) {
+		if (entry->key == key)
+			return entry;
+	}
+	return NULL;
+}
+
+static void __stripeGrowIfNeeded(struct _wd_dispatch_stripe_t *restrict stripe) {
+	if (stripe->count < stripe->capacity)
+		return;
+	size_t capacity = stripe->capacity * 2;
+	struct KeyHead *buckets = calloc(capacity, sizeof(struct KeyHead));
+	/* A crowded stripe is still correct, only slower */
+	if (NULL == buckets)
+		return;
+	for (size_t i=0; i<stripe->capacity; i++) {
+		struct _wd_dispatch_key_t *entry;
+		while (NULL != (entry = LIST_FIRST(&stripe->buckets[i]))) {
+			LIST_REMOVE(entry, bucket);
+			LIST_INSERT_HEAD(&buckets[(__hash(entry->key) >> 32) & (capacity - 1)], entry, bucket);
+		}
+	}
+	free(stripe->buckets);
+	stripe->buckets = buckets;
+	stripe->capacity = capacity;
+}
+
+static unsigned int __leastLoadedLane(WDShardedDispatcher *restrict dispatcher) {
+	unsigned int lane = 0;
+	unsigned long minimum = __atomic_load_n(&dispatcher->lanes[0]->backlog, __ATOMIC_RELAXED);
+	for (unsigned int i=1; i<dispatcher->count && minimum > 0; i++) {
+		unsigned long backlog = __atomic_load_n(&dispatcher->lanes[i]->backlog, __ATOMIC_RELAXED);
+		if (backlog < minimum) {
+			minimum = backlog;
+			lane = i;
+		}
+	}
+	return lane;
+}
+
+static unsigned int __chooseLane(WDShardedDispatcher *restrict dispatcher, unsigned int home) {
+	unsigned int factor = __atomic_load_n(&dispatcher->rebalanceFactor, __ATOMIC_RELAXED);
+	if (0 == factor || dispatcher->count < 2)
+		return home;
+	unsigned long backlog = __atomic_load_n(&dispatcher->lanes[home]->backlog, __ATOMIC_RELAXED);
+	if (backlog < WDShardedDispatcherRebalanceMinimumBacklog)
+		return home;
+	/* Only a busy home lane gets here, the lanes are not summed on the common path */
+	unsigned long total = 0;
+	for (unsigned int i=0; i<dispatcher->count; i++)
+		total += __atomic_load_n(&dispatcher->lanes[i]->backlog, __ATOMIC_RELAXED);
+	if (backlog <= factor * (total / dispatcher->count))
+		return home;
+	unsigned int lane = __leastLoadedLane(dispatcher);
+	if (lane != home)
+		__atomic_add_fetch(&dispatcher->rebalanced, 1, __ATOMIC_RELAXED);
+	return lane;
+}
+
+/* Must be called with the lane's mutex held */
+static int __laneSchedule(WDShardedDispatcher *restrict dispatcher, struct _wd_dispatch_lane_t *restrict lane) {
+	WDOperation *operation = WDOperationCreate(WDShardedDispatcherDrain, lane);
+	if (NULL == operation)
+		return lane->scheduled = 0, errno = ENOMEM, -WDShardedDispatcherResultFailure;
+	int result = WDOperationQueueAddOperation(dispatcher->queue, operation);
+	release(operation);
+	lane->scheduled = (result >= 0);
+	return result < 0 ? -WDShardedDispatcherResultFailure : WDShardedDispatcherResultSuccess;
+}
+
+static int __lanesEmpty(WDShardedDispatcher *restrict dispatcher) {
+	for (unsigned int i=0; i<dispatcher->count; i++) {
+		if (0 != __atomic_load_n(&dispatcher->lanes[i]->backlog, __ATOMIC_SEQ_CST))
+			return 0;
+	}
+	return 1;
+}
+
+/* Counts a function of the lane as finished, the waiters are told once the lane is empty */
+static void __laneFinished(WDShardedDispatcher *restrict dispatcher, struct _wd_dispatch_lane_t *restrict lane) {
+	/* A waiter registers before it looks at the backlogs, one of both sides sees the other */
+	if (0 == __atomic_sub_fetch(&lane->backlog, 1, __ATOMIC_SEQ_CST) && 0 != __atomic_load_n(&dispatcher->wait.waiters, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&dispatcher->wait.mutex);
+		pthread_cond_broadcast(&dispatcher->wait.condition);
+		pthread_mutex_unlock(&dispatcher->wait.mutex);
+	}
+}
+
+/* Forgets the key once its last function has finished, the key may then be placed in another lane */
+static void __keyFinished(WDShardedDispatcher *restrict dispatcher, uint64_t key) {
+	uint64_t hash = __hash(key);
+	struct _wd_dispatch_stripe_t *stripe = &dispatcher->stripes[hash % dispatcher->count];
+	pthread_mutex_lock(&stripe->mutex);
+	struct _wd_dispatch_key_t *entry = __stripeFind(stripe, hash, key);
+	if (NULL != entry && 0 == --entry->pending) {
+		LIST_REMOVE(entry, bucket);
+		stripe->count--;
+		free(entry);
+	}
+	pthread_mutex_unlock(&stripe->mutex);
+}
+
+WDShardedDispatcher *WDShardedDispatcherAllocate(unsigned int lanes, unsigned int workers) {
+	if (0 == lanes || 0 == workers)
+		return errno = EINVAL, (WDShardedDispatcher *)NULL;
+
+	WDShardedDispatcher *dispatcher = MEMORY_MANAGEMENT_ALLOC(sizeof(WDShardedDispatcher));
+	if ( dispatcher == NULL ) return errno = ENOMEM, (WDShardedDispatcher *)NULL;
+
+	dispatcher->lanes = calloc(lanes, sizeof(struct _wd_dispatch_lane_t *));
+	dispatcher->stripes = calloc(lanes, sizeof(struct _wd_dispatch_stripe_t));
+	dispatcher->queue = WDOperationQueueAllocate();
+	if (NULL == dispatcher->lanes || NULL == dispatcher->stripes || NULL == dispatcher->queue)
+		goto failure;
+
+	for (unsigned int i=0; i<lanes; i++) {
+		struct _wd_dispatch_stripe_t *stripe = &dispatcher->stripes[i];
+		stripe->buckets = calloc(WDShardedDispatcherIndexInitialCapacity, sizeof(struct KeyHead));
+		dispatcher->lanes[i] = MEMORY_MANAGEMENT_ALLOC(sizeof(struct _wd_dispatch_lane_t));
+		if (NULL == stripe->buckets || NULL == dispatcher->lanes[i])
+			goto failure;
+		stripe->capacity = WDShardedDispatcherIndexInitialCapacity;
+	}
+	for (unsigned int i=0; i<lanes; i++) {
+		struct _wd_dispatch_lane_t *lane = dispatcher->lanes[i];
+		MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(lane, WDShardedDispatcherLaneDealloc);
+		pthread_mutex_init(&lane->mutex, NULL);
+		TAILQ_INIT(&lane->items);
+		lane->dispatcher = dispatcher;
+		pthread_mutex_init(&dispatcher->stripes[i].mutex, NULL);
+	}
+	dispatcher->count = lanes;
+	dispatcher->rebalanceFactor = WDShardedDispatcherDefaultRebalanceFactor;
+	pthread_mutex_init(&dispatcher->wait.mutex, NULL);
+	pthread_cond_init(&dispatcher->wait.condition, NULL);
+
+	/* A fixed pool, the workers are started on demand */
+	WDOperationQueueSetWorkerLimits(dispatcher->queue, workers, workers);
+	WDOperationQueueSetName(dispatcher->queue, "WDShardedDispatcher");
+	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(dispatcher, WDShardedDispatcherDealloc);
+	return dispatcher;
+
+failure:
+	for (unsigned int i=0; i<lanes; i++) {
+		if (NULL != dispatcher->stripes)
+			free(dispatcher->stripes[i].buckets);
+		if (NULL != dispatcher->lanes)
+			release(dispatcher->lanes[i]);
+	}
+	free(dispatcher->stripes);
+	free(dispatcher->lanes);
+	release(dispatcher->queue);
+	release(dispatcher);
+	return errno = ENOMEM, (WDShardedDispatcher *)NULL;
+}
+
+void WDShardedDispatcherDealloc(void *_dispatcher) {
+	if (NULL == _dispatcher) return;
+	WDShardedDispatcher *dispatcher = _dispatcher;
+
+	/* Every dispatched function is executed, then the drain operations are let go */
+	WDShardedDispatcherWaitAllFunctions(dispatcher);
+	WDOperationQueueWaitAllOperations(dispatcher->queue);
+	release(dispatcher->queue);
+
+	for (unsigned int i=0; i<dispatcher->count; i++) {
+		struct _wd_dispatch_stripe_t *stripe = &dispatcher->stripes[i];
+		for (size_t j=0; j<stripe->capacity; j++) {
+			struct _wd_dispatch_key_t *entry;
+			while (NULL != (entry = LIST_FIRST(&stripe->buckets[j]))) {
+				LIST_REMOVE(entry, bucket);
+				free(entry);
+			}
+		}
+		free(stripe->buckets);
+		pthread_mutex_destroy(&stripe->mutex);
+		release(dispatcher->lanes[i]);
+	}
+	free(dispatcher->stripes);
+	free(dispatcher->lanes);
+	pthread_mutex_destroy(&dispatcher->wait.mutex);
+	pthread_cond_destroy(&dispatcher->wait.condition);
+}
+
+void WDShardedDispatcherLaneDealloc(void *_lane) {
+	if (NULL == _lane) return;
+	struct _wd_dispatch_lane_t *lane = _lane;
+	pthread_mutex_destroy(&lane->mutex);
+}
+
+WDShardedDispatcher *WDShardedDispatcherRetain(WDShardedDispatcher *dispatcher) {
+	return retain(dispatcher);
+}
+
+void WDShardedDispatcherRelease(WDShardedDispatcher *dispatcher) {
+	release(dispatcher);
+}
+
+int WDShardedDispatcherDispatch(WDShardedDispatcher *dispatcher, uint64_t key, wd_operation_f function, void *argument) {
+	if (NULL == dispatcher || NULL == function)
+		return errno = EINVAL, -WDShardedDispatcherResultFailure;
+
+	struct _wd_dispatch_item_t *item = malloc(sizeof(struct _wd_dispatch_item_t));
+	if (NULL == item)
+		return errno = ENOMEM, -WDShardedDispatcherResultFailure;
+	item->function = function;
+	item->argument = retain(argument);
+	item->key = key;
+
+	uint64_t hash = __hash(key);
+	unsigned int home = (unsigned int)(hash % dispatcher->count);
+	struct _wd_dispatch_stripe_t *stripe = &dispatcher->stripes[home];
+
+	pthread_mutex_lock(&stripe->mutex);
+	struct _wd_dispatch_key_t *entry = __stripeFind(stripe, hash, key);
+	if (NULL == entry) {
+		/* The key has nothing pending, it can be placed anywhere without breaking its order */
+		entry = malloc(sizeof(struct _wd_dispatch_key_t));
+		if (NULL == entry) {
+			pthread_mutex_unlock(&stripe->mutex);
+			release(item->argument);
+			free(item);
+			return errno = ENOMEM, -WDShardedDispatcherResultFailure;
+		}
+		entry->key = key;
+		entry->pending = 0;
+		entry->lane = __chooseLane(dispatcher, home);
+		__stripeGrowIfNeeded(stripe);
+		LIST_INSERT_HEAD(&stripe->buckets[(hash >> 32) & (stripe->capacity - 1)], entry, bucket);
+		stripe->count++;
+	}
+	entry->pending++;
+
+	struct _wd_dispatch_lane_t *lane = dispatcher->lanes[entry->lane];
+	__atomic_add_fetch(&lane->backlog, 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&lane->mutex);
+	pthread_mutex_unlock(&stripe->mutex);
+	TAILQ_INSERT_TAIL(&lane->items, item, items);
+	if (lane->scheduled || __laneSchedule(dispatcher, lane) == WDShardedDispatcherResultSuccess) {
+		pthread_mutex_unlock(&lane->mutex);
+		return WDShardedDispatcherResultSuccess;
+	}
+
+	/* Nothing drains the lane, take the function back */
+	int error = errno;
+	TAILQ_REMOVE(&lane->items, item, items);
+	pthread_mutex_unlock(&lane->mutex);
+	__laneFinished(dispatcher, lane);
+	__keyFinished(dispatcher, key);
+	release(item->argument);
+	free(item);
+	return errno = error, -WDShardedDispatcherResultFailure;
+}
+
+void WDShardedDispatcherDrain(WDOperation *operation, void *argument) {
+	struct _wd_dispatch_lane_t *lane = argument;
+	WDShardedDispatcher *dispatcher = lane->dispatcher;
+	struct ItemHead batch = TAILQ_HEAD_INITIALIZER(batch);
+
+	/* Take a bounded batch so that the other lanes get their share of the workers */
+	pthread_mutex_lock(&lane->mutex);
+	for (unsigned int i=0; i<WDShardedDispatcherDrainBudget && !TAILQ_EMPTY(&lane->items); i++) {
+		struct _wd_dispatch_item_t *item = TAILQ_FIRST(&lane->items);
+		TAILQ_REMOVE(&lane->items, item, items);
+		TAILQ_INSERT_TAIL(&batch, item, items);
+	}
+	pthread_mutex_unlock(&lane->mutex);
+
+	struct _wd_dispatch_item_t *item;
+	while (NULL != (item = TAILQ_FIRST(&batch))) {
+		TAILQ_REMOVE(&batch, item, items);
+		item->function(operation, item->argument);
+		release(item->argument);
+		__keyFinished(dispatcher, item->key);
+		free(item);
+		__laneFinished(dispatcher, lane);
+	}
+
+	pthread_mutex_lock(&lane->mutex);
+	if (TAILQ_EMPTY(&lane->items))
+		lane->scheduled = 0;
+	else /* On failure the lane is scheduled again by the next function dispatched to it */
+		__laneSchedule(dispatcher, lane);
+	pthread_mutex_unlock(&lane->mutex);
+}
+
+void WDShardedDispatcherSetRebalanceFactor(WDShardedDispatcher *dispatcher, unsigned int factor) {
+	if (NULL == dispatcher) return;
+	__atomic_store_n(&dispatcher->rebalanceFactor, factor, __ATOMIC_RELAXED);
+}
+
+uint64_t WDShardedDispatcherGetRebalancedKeys(WDShardedDispatcher *dispatcher) {
+	if (NULL == dispatcher) return 0;
+	return __atomic_load_n(&dispatcher->rebalanced, __ATOMIC_RELAXED);
+}
+
+void WDShardedDispatcherWaitAllFunctions(WDShardedDispatcher *dispatcher) {
+	if (NULL == dispatcher) return;
+	pthread_mutex_lock(&dispatcher->wait.mutex);
+	__atomic_add_fetch(&dispatcher->wait.waiters, 1, __ATOMIC_SEQ_CST);
+	while (!__lanesEmpty(dispatcher))
+		pthread_cond_wait(&dispatcher->wait.condition, &dispatcher->wait.mutex);
+	__atomic_sub_fetch(&dispatcher->wait.waiters, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&dispatcher->wait.mutex);
+}
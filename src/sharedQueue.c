@@ -0,0 +1,556 @@
+/*!
+ *  @file sharedQueue.c
+ *
+ *  Created by @author George Boumis
+ *  @date 2026/10/18.
+ *	@version 1.1
+ *  @copyright Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <memory_management/memory_management.h>
+#include "sharedQueue.h"
+
+#define WDSharedQueueResultSuccess 0
+#define WDSharedQueueResultFailure 1
+
+#define WDSharedQueueMaximumFunctions 256
+
+static wd_shared_operation_f __functions[WDSharedQueueMaximumFunctions];
+
+int WDSharedQueueRegisterFunction(uint32_t identifier, wd_shared_operation_f function) {
+	if (identifier >= WDSharedQueueMaximumFunctions)
+		return errno = EINVAL, -WDSharedQueueResultFailure;
+	__atomic_store_n(&__functions[identifier], function, __ATOMIC_RELEASE);
+	return WDSharedQueueResultSuccess;
+}
+
+#ifdef __linux__
+
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define WDSharedQueueMagic 0x57445351u /* WDSQ */
+#define WDSharedQueueVersion 3
+#define WDSharedQueueMaximumAttempts 3
+#define WDSharedQueueRecoveryInterval 100 /* milliseconds, how often the processes look for dead workers */
+#define WDSharedQueueNone UINT32_MAX
+
+#define WDCacheLineSize 64
+#define WDCacheLineRound(size) (((size) + WDCacheLineSize - 1) & ~(size_t)(WDCacheLineSize - 1))
+
+void WDSharedQueueDealloc(void *queue) __attribute__((visibility("internal")));
+
+enum {
+	WDSharedSlotFree = 0,
+	WDSharedSlotReady,
+	WDSharedSlotClaimed
+};
+
+/*!
+ *  @struct _wd_shared_slot_t
+ *  @brief An operation in the shared region, followed by its payload.
+ *  @ingroup wd
+ *	@details The state of a slot is the truth the lists of the header are rebuilt from when a process dies holding the lock, so it is always written before the slot is linked.
+ *
+ *	The thread executing an operation holds the robust mutex of its slot, the kernel releases it as soon as the thread dies. Unlike a process identifier this token cannot be recycled by another process.
+ */
+struct _wd_shared_slot_t {
+	pthread_mutex_t owner; /*!< held by the thread executing the operation, a process-shared robust mutex */
+	uint32_t state; /*!< see `WDSharedSlotFree` */
+	uint32_t next; /*!< the next slot in the free or ready list */
+	uint32_t attempts; /*!< how many times the operation was claimed */
+	uint32_t function; /*!< the registered identifier of the function */
+	uint32_t size; /*!< the size of the payload */
+	uint64_t sequence; /*!< the order of arrival */
+};
+
+/*!
+ *  @struct _wd_shared_header_t
+ *  @brief The beginning of the shared region.
+ *  @ingroup wd
+ *	@details Everything but the futex words is protected by `mutex`, a process-shared robust mutex. The futex words are only accessed atomically.
+ */
+struct _wd_shared_header_t {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t payloadSize;
+	uint64_t slotSize;
+	uint64_t length; /*!< the size of the region */
+	pthread_mutex_t mutex;
+	uint32_t freeHead;
+	uint32_t readyHead;
+	uint32_t readyTail;
+	uint32_t pending; /*!< the length of the ready list */
+	uint32_t consumersWaiting;
+	uint32_t producersWaiting;
+	uint32_t shutdown;
+	uint64_t sequence;
+	uint64_t recovery; /*!< the last time a process looked for dead workers, in milliseconds of `CLOCK_MONOTONIC` */
+	wd_shared_queue_statistics_t statistics;
+	char padding[WDCacheLineSize];
+	uint32_t items; /*!< futex word, incremented when an operation becomes ready */
+	char itemsPadding[WDCacheLineSize];
+	uint32_t spaces; /*!< futex word, incremented when a slot becomes free */
+};
+
+/*!
+ *  @struct _wd_shared_queue_t
+ *  @brief The mapping of a shared region in the current process.
+ *  @ingroup wd
+ */
+struct _wd_shared_queue_t {
+	int fd;
+	size_t length;
+	struct _wd_shared_header_t *header;
+	unsigned char *slots;
+};
+
+static inline uint64_t __nowMilliseconds(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+static inline struct _wd_shared_slot_t *__slot(WDSharedQueue *restrict queue, uint32_t index) {
+	return (struct _wd_shared_slot_t *)(queue->slots + (size_t)index * queue->header->slotSize);
+}
+
+static inline void *__payload(struct _wd_shared_slot_t *restrict slot) {
+	return (unsigned char *)slot + WDCacheLineRound(sizeof(struct _wd_shared_slot_t));
+}
+
+/* A full barrier, what follows is never visible to the other processes before the state */
+static inline void __slotSetState(struct _wd_shared_slot_t *restrict slot, uint32_t state) {
+	__atomic_store_n(&slot->state, state, __ATOMIC_SEQ_CST);
+}
+
+static int __futexWait(uint32_t *word, uint32_t expected, int milliseconds) {
+	struct timespec timeout = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000 };
+	return (int)syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void __futexWake(uint32_t *word, int count) {
+	syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+}
+
+static void __freePush(WDSharedQueue *restrict queue, uint32_t index) {
+	struct _wd_shared_header_t *header = queue->header;
+	__slot(queue, index)->next = header->freeHead;
+	header->freeHead = index;
+}
+
+static void __readyAppend(WDSharedQueue *restrict queue, uint32_t index) {
+	struct _wd_shared_header_t *header = queue->header;
+	__slot(queue, index)->next = WDSharedQueueNone;
+	if (WDSharedQueueNone == header->readyTail)
+		header->readyHead = index;
+	else
+		__slot(queue, header->readyTail)->next = index;
+	header->readyTail = index;
+	header->pending++;
+}
+
+static void __readyPrepend(WDSharedQueue *restrict queue, uint32_t index) {
+	struct _wd_shared_header_t *header = queue->header;
+	__slot(queue, index)->next = header->readyHead;
+	header->readyHead = index;
+	if (WDSharedQueueNone == header->readyTail)
+		header->readyTail = index;
+	header->pending++;
+}
+
+static uint32_t __readyPop(WDSharedQueue *restrict queue) {
+	struct _wd_shared_header_t *header = queue->header;
+	uint32_t index = header->readyHead;
+	header->readyHead = __slot(queue, index)->next;
+	if (WDSharedQueueNone == header->readyHead)
+		header->readyTail = WDSharedQueueNone;
+	header->pending--;
+	return index;
+}
+
+/* Rebuilds the lists from the states of the slots after a process died in the middle of changing them */
+static void __rebuild(WDSharedQueue *restrict queue) {
+	struct _wd_shared_header_t *header = queue->header;
+	header->freeHead = header->readyHead = header->readyTail = WDSharedQueueNone;
+	header->pending = 0;
+	for (uint32_t i=header->capacity; i-- > 0;) {
+		struct _wd_shared_slot_t *slot = __slot(queue, i);
+		if (WDSharedSlotFree == slot->state)
+			__freePush(queue, i);
+		else if (WDSharedSlotReady == slot->state) {
+			/* Keep the order of arrival, this is rare enough for an insertion */
+			uint32_t *link = &header->readyHead;
+			while (WDSharedQueueNone != *link && __slot(queue, *link)->sequence < slot->sequence)
+				link = &__slot(queue, *link)->next;
+			slot->next = *link;
+			*link = i;
+			if (WDSharedQueueNone == slot->next)
+				header->readyTail = i;
+			header->pending++;
+		}
+	}
+}
+
+static int __lock(WDSharedQueue *restrict queue) {
+	int error = pthread_mutex_lock(&queue->header->mutex);
+	if (EOWNERDEAD == error) {
+		__rebuild(queue);
+		error = pthread_mutex_consistent(&queue->header->mutex);
+	}
+	return error ? (errno = error, -WDSharedQueueResultFailure) : WDSharedQueueResultSuccess;
+}
+
+static inline void __unlock(WDSharedQueue *restrict queue) {
+	pthread_mutex_unlock(&queue->header->mutex);
+}
+
+/* Gives back the operations claimed by the dead processes, must be called with the lock held */
+static void __recover(WDSharedQueue *restrict queue) {
+	struct _wd_shared_header_t *header = queue->header;
+	unsigned int requeued = 0, freed = 0;
+	for (uint32_t i=header->capacity; i-- > 0;) {
+		struct _wd_shared_slot_t *slot = __slot(queue, i);
+		if (WDSharedSlotClaimed != slot->state)
+			continue;
+		/* A live executor keeps the mutex busy, even in the current process */
+		int error = pthread_mutex_trylock(&slot->owner);
+		if (EOWNERDEAD != error) {
+			if (0 == error)
+				pthread_mutex_unlock(&slot->owner);
+			continue;
+		}
+		pthread_mutex_consistent(&slot->owner);
+		pthread_mutex_unlock(&slot->owner);
+		if (slot->attempts < WDSharedQueueMaximumAttempts) {
+			/* It was the oldest operation when it was claimed */
+			__slotSetState(slot, WDSharedSlotReady);
+			__readyPrepend(queue, i);
+			header->statistics.recovered++;
+			requeued++;
+		}
+		else {
+			/* The operation keeps killing its workers */
+			__slotSetState(slot, WDSharedSlotFree);
+			__freePush(queue, i);
+			header->statistics.abandoned++;
+			freed++;
+		}
+	}
+	if (requeued) {
+		__atomic_add_fetch(&header->items, 1, __ATOMIC_SEQ_CST);
+		__futexWake(&header->items, INT_MAX);
+	}
+	if (freed) {
+		__atomic_add_fetch(&header->spaces, 1, __ATOMIC_SEQ_CST);
+		__futexWake(&header->spaces, INT_MAX);
+	}
+}
+
+/* Looks for dead workers once per recovery interval, whether the processes wait or always find work, must be called with the lock held */
+static void __recoverIfDue(WDSharedQueue *restrict queue) {
+	uint64_t now = __nowMilliseconds();
+	if (now - queue->header->recovery < WDSharedQueueRecoveryInterval)
+		return;
+	queue->header->recovery = now;
+	__recover(queue);
+}
+
+/* Sleeps on a futex word with the lock released, returns `1` when the caller's deadline expired with the lock held and a negative value when the lock was lost */
+static int __wait(WDSharedQueue *restrict queue, uint32_t *word, uint32_t *waiting, int timeout, uint64_t deadline) {
+	int milliseconds = WDSharedQueueRecoveryInterval;
+	if (timeout >= 0) {
+		uint64_t now = __nowMilliseconds();
+		if (now >= deadline)
+			return 1;
+		if (deadline - now < (uint64_t)milliseconds)
+			milliseconds = (int)(deadline - now);
+	}
+	uint32_t observed = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+	(*waiting)++;
+	__unlock(queue);
+	__futexWait(word, observed, milliseconds);
+	if (__lock(queue) < 0)
+		return -WDSharedQueueResultFailure;
+	(*waiting)--;
+	__recoverIfDue(queue);
+	return 0;
+}
+
+static WDSharedQueue *__map(int fd, size_t length) {
+	void *region = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == region)
+		return NULL;
+	WDSharedQueue *queue = MEMORY_MANAGEMENT_ALLOC(sizeof(WDSharedQueue));
+	if (NULL == queue) {
+		munmap(region, length);
+		return errno = ENOMEM, (WDSharedQueue *)NULL;
+	}
+	queue->fd = fd;
+	queue->length = length;
+	queue->header = region;
+	queue->slots = (unsigned char *)region + WDCacheLineRound(sizeof(struct _wd_shared_header_t));
+	MEMORY_MANAGEMENT_ATTRIBUTE_SET_DEALLOC_FUNCTION(queue, WDSharedQueueDealloc);
+	return queue;
+}
+
+WDSharedQueue *WDSharedQueueCreate(const char *name, unsigned int capacity, size_t payloadSize) {
+	if (0 == capacity || capacity >= WDSharedQueueNone || payloadSize > UINT32_MAX)
+		return errno = EINVAL, (WDSharedQueue *)NULL;
+
+	size_t slotSize = WDCacheLineRound(WDCacheLineRound(sizeof(struct _wd_shared_slot_t)) + payloadSize);
+	size_t length = WDCacheLineRound(sizeof(struct _wd_shared_header_t)) + (size_t)capacity * slotSize;
+	int fd = memfd_create(NULL != name ? name : "WDSharedQueue", MFD_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+	WDSharedQueue *queue = NULL;
+	if (ftruncate(fd, (off_t)length) < 0 || NULL == (queue = __map(fd, length))) {
+		int error = errno;
+		close(fd);
+		return errno = error, (WDSharedQueue *)NULL;
+	}
+
+	/* The region is zeroed, every slot starts free */
+	struct _wd_shared_header_t *header = queue->header;
+	header->version = WDSharedQueueVersion;
+	header->capacity = capacity;
+	header->payloadSize = (uint32_t)payloadSize;
+	header->slotSize = slotSize;
+	header->length = length;
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+	pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+	pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+	pthread_mutex_init(&header->mutex, &attributes);
+	header->readyHead = header->readyTail = header->freeHead = WDSharedQueueNone;
+	for (uint32_t i=capacity; i-- > 0;) {
+		pthread_mutex_init(&__slot(queue, i)->owner, &attributes);
+		__freePush(queue, i);
+	}
+	pthread_mutexattr_destroy(&attributes);
+	__atomic_store_n(&header->magic, WDSharedQueueMagic, __ATOMIC_RELEASE);
+	return queue;
+}
+
+WDSharedQueue *WDSharedQueueOpen(int fd) {
+	struct stat status;
+	struct _wd_shared_header_t header;
+	if (fstat(fd, &status) < 0)
+		return NULL;
+	if ((size_t)status.st_size < sizeof(header) || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+		|| WDSharedQueueMagic != header.magic || WDSharedQueueVersion != header.version || header.length != (uint64_t)status.st_size)
+		return errno = EINVAL, (WDSharedQueue *)NULL;
+	/* The slots must hold their payload and fit in the region, the header comes from another process */
+	uint64_t slots = WDCacheLineRound(sizeof(struct _wd_shared_header_t));
+	if (0 == header.capacity || header.capacity >= WDSharedQueueNone || header.length < slots
+		|| header.slotSize < WDCacheLineRound(sizeof(struct _wd_shared_slot_t)) + (uint64_t)header.payloadSize
+		|| header.slotSize > (header.length - slots) / header.capacity)
+		return errno = EINVAL, (WDSharedQueue *)NULL;
+
+	int duplicate = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (duplicate < 0)
+		return NULL;
+	WDSharedQueue *queue = __map(duplicate, (size_t)status.st_size);
+	if (NULL == queue) {
+		int error = errno;
+		close(duplicate);
+		return errno = error, (WDSharedQueue *)NULL;
+	}
+	return queue;
+}
+
+void WDSharedQueueDealloc(void *_queue) {
+	if (NULL == _queue) return;
+	WDSharedQueue *queue = _queue;
+	munmap(queue->header, queue->length);
+	close(queue->fd);
+}
+
+int WDSharedQueueGetFileDescriptor(WDSharedQueue *queue) {
+	if (NULL == queue)
+		return errno = EINVAL, -WDSharedQueueResultFailure;
+	return queue->fd;
+}
+
+WDSharedQueue *WDSharedQueueRetain(WDSharedQueue *queue) {
+	return retain(queue);
+}
+
+void WDSharedQueueRelease(WDSharedQueue *queue) {
+	release(queue);
+}
+
+int WDSharedQueueAddOperation(WDSharedQueue *queue, uint32_t function, const void *payload, size_t size, int timeout) {
+	if (NULL == queue || size > queue->header->payloadSize || (size > 0 && NULL == payload))
+		return errno = EINVAL, -WDSharedQueueResultFailure;
+
+	struct _wd_shared_header_t *header = queue->header;
+	uint64_t deadline = timeout > 0 ? __nowMilliseconds() + (uint64_t)timeout : 0;
+	if (__lock(queue) < 0)
+		return -WDSharedQueueResultFailure;
+	__recoverIfDue(queue);
+	while (WDSharedQueueNone == header->freeHead || header->shutdown) {
+		if (header->shutdown)
+			return __unlock(queue), errno = ECANCELED, -WDSharedQueueResultFailure;
+		if (0 == timeout)
+			return __unlock(queue), errno = EAGAIN, -WDSharedQueueResultFailure;
+		int waited = __wait(queue, &header->spaces, &header->producersWaiting, timeout, deadline);
+		if (waited < 0)
+			return -WDSharedQueueResultFailure;
+		if (waited > 0)
+			return __unlock(queue), errno = ETIMEDOUT, -WDSharedQueueResultFailure;
+	}
+
+	uint32_t index = header->freeHead;
+	struct _wd_shared_slot_t *slot = __slot(queue, index);
+	header->freeHead = slot->next;
+	slot->function = function;
+	slot->size = (uint32_t)size;
+	slot->attempts = 0;
+	slot->sequence = header->sequence++;
+	if (size > 0)
+		memcpy(__payload(slot), payload, size);
+	__slotSetState(slot, WDSharedSlotReady);
+	__readyAppend(queue, index);
+	header->statistics.enqueued++;
+	__atomic_add_fetch(&header->items, 1, __ATOMIC_SEQ_CST);
+	int wake = header->consumersWaiting > 0;
+	__unlock(queue);
+
+	if (wake)
+		__futexWake(&header->items, 1);
+	return WDSharedQueueResultSuccess;
+}
+
+int WDSharedQueuePerformNext(WDSharedQueue *queue, int timeout) {
+	if (NULL == queue)
+		return errno = EINVAL, -WDSharedQueueResultFailure;
+
+	struct _wd_shared_header_t *header = queue->header;
+	uint64_t deadline = timeout > 0 ? __nowMilliseconds() + (uint64_t)timeout : 0;
+	if (__lock(queue) < 0)
+		return -WDSharedQueueResultFailure;
+	__recoverIfDue(queue);
+	while (WDSharedQueueNone == header->readyHead) {
+		if (header->shutdown)
+			return __unlock(queue), errno = ECANCELED, -WDSharedQueueResultFailure;
+		if (0 == timeout)
+			return __unlock(queue), errno = EAGAIN, -WDSharedQueueResultFailure;
+		int waited = __wait(queue, &header->items, &header->consumersWaiting, timeout, deadline);
+		if (waited < 0)
+			return -WDSharedQueueResultFailure;
+		if (waited > 0)
+			return __unlock(queue), errno = ETIMEDOUT, -WDSharedQueueResultFailure;
+	}
+
+	uint32_t index = __readyPop(queue);
+	struct _wd_shared_slot_t *slot = __slot(queue, index);
+	/* Nobody holds the mutex of a ready slot, unless its last claimer died before marking it claimed */
+	if (EOWNERDEAD == pthread_mutex_lock(&slot->owner))
+		pthread_mutex_consistent(&slot->owner);
+	slot->attempts++;
+	__slotSetState(slot, WDSharedSlotClaimed);
+	__unlock(queue);
+
+	/* The payload stays in place, no other process touches a claimed slot */
+	wd_shared_operation_f function = slot->function < WDSharedQueueMaximumFunctions ? __atomic_load_n(&__functions[slot->function], __ATOMIC_ACQUIRE) : NULL;
+	if (NULL != function)
+		function(queue, __payload(slot), slot->size);
+
+	if (__lock(queue) < 0)
+		return -WDSharedQueueResultFailure;
+	__slotSetState(slot, WDSharedSlotFree);
+	__freePush(queue, index);
+	pthread_mutex_unlock(&slot->owner);
+	if (NULL != function)
+		header->statistics.executed++;
+	else
+		header->statistics.abandoned++;
+	__atomic_add_fetch(&header->spaces, 1, __ATOMIC_SEQ_CST);
+	int wake = header->producersWaiting > 0;
+	__unlock(queue);
+
+	if (wake)
+		__futexWake(&header->spaces, 1);
+	return NULL != function ? WDSharedQueueResultSuccess : (errno = ENOENT, -WDSharedQueueResultFailure);
+}
+
+void WDSharedQueueShutdown(WDSharedQueue *queue) {
+	if (NULL == queue) return;
+	struct _wd_shared_header_t *header = queue->header;
+	if (__lock(queue) < 0)
+		return;
+	header->shutdown = 1;
+	__atomic_add_fetch(&header->items, 1, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&header->spaces, 1, __ATOMIC_SEQ_CST);
+	__unlock(queue);
+	__futexWake(&header->items, INT_MAX);
+	__futexWake(&header->spaces, INT_MAX);
+}
+
+int WDSharedQueueGetStatistics(WDSharedQueue *queue, wd_shared_queue_statistics_t *statistics) {
+	if (NULL == queue || NULL == statistics)
+		return errno = EINVAL, -WDSharedQueueResultFailure;
+	if (__lock(queue) < 0)
+		return -WDSharedQueueResultFailure;
+	*statistics = queue->header->statistics;
+	statistics->pending = queue->header->pending;
+	__unlock(queue);
+	return WDSharedQueueResultSuccess;
+}
+
+#else
+
+WDSharedQueue *WDSharedQueueCreate(const char *name __attribute__((unused)), unsigned int capacity __attribute__((unused)), size_t payloadSize __attribute__((unused))) {
+	return errno = ENOSYS, (WDSharedQueue *)NULL;
+}
+
+WDSharedQueue *WDSharedQueueOpen(int fd __attribute__((unused))) {
+	return errno = ENOSYS, (WDSharedQueue *)NULL;
+}
+
+int WDSharedQueueGetFileDescriptor(WDSharedQueue *queue __attribute__((unused))) {
+	return errno = ENOSYS, -WDSharedQueueResultFailure;
+}
+
+WDSharedQueue *WDSharedQueueRetain(WDSharedQueue *queue) {
+	return retain(queue);
+}
+
+void WDSharedQueueRelease(WDSharedQueue *queue) {
+	release(queue);
+}
+
+int WDSharedQueueAddOperation(WDSharedQueue *queue __attribute__((unused)), uint32_t function __attribute__((unused)), const void *payload __attribute__((unused)), size_t size __attribute__((unused)), int timeout __attribute__((unused))) {
+	return errno = ENOSYS, -WDSharedQueueResultFailure;
+}
+
+int WDSharedQueuePerformNext(WDSharedQueue *queue __attribute__((unused)), int timeout __attribute__((unused))) {
+	return errno = ENOSYS, -WDSharedQueueResultFailure;
+}
+
+void WDSharedQueueShutdown(WDSharedQueue *queue __attribute__((unused))) {
+}
+
+int WDSharedQueueGetStatistics(WDSharedQueue *queue __attribute__((unused)), wd_shared_queue_statistics_t *statistics __attribute__((unused))) {
+	return errno = ENOSYS, -WDSharedQueueResultFailure;
+}
+
+#endif
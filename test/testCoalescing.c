@@ -0,0 +1,63 @@
+//
+//  testCoalescing.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define ITER 100
+#define SHARDS 4
+
+struct refresh {
+	unsigned int shard;
+	unsigned int requests;
+};
+
+static unsigned int executions = 0;
+
+void refreshf(WDOperation *operation, void *arg);
+void mergef(void *pendingArgument, void *incomingArgument);
+
+int main () {
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetName(operationQueue, "queue.coalescing");
+	
+	/* Keep everything pending while the burst arrives */
+	WDOperationQueueSuspend(operationQueue, 1);
+	unsigned int coalesced = 0;
+	for (unsigned int i=0; i<ITER; i++) {
+		struct refresh *refresh = MEMORY_MANAGEMENT_ALLOC(sizeof(struct refresh));
+		refresh->shard = i % SHARDS;
+		refresh->requests = 1;
+		WDOperation *operation = WDOperationCreate(refreshf, refresh);
+		if (WDOperationQueueAddOperationWithKey(operationQueue, operation, refresh->shard, mergef) == 1)
+			coalesced++;
+		release(operation);
+		release(refresh);
+	}
+	WDOperationQueueSuspend(operationQueue, 0);
+	WDOperationQueueWaitAllOperations(operationQueue);
+	
+	printf("%u operations submitted, %u coalesced, %u executed\n", ITER, coalesced, executions);
+	release(operationQueue);
+	return (executions == SHARDS && coalesced == ITER - SHARDS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void refreshf(WDOperation *operation, void *arg) {
+	(void)operation;
+	struct refresh *refresh = arg;
+	executions++;
+	printf("Refreshing shard %u for %u requests\n", refresh->shard, refresh->requests);
+}
+
+void mergef(void *pendingArgument, void *incomingArgument) {
+	struct refresh *pending = pendingArgument, *incoming = incomingArgument;
+	pending->requests += incoming->requests;
+}
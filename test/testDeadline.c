@@ -0,0 +1,133 @@
+//
+//  testDeadline.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define ITER 5
+
+void opf(WDOperation *operation, void *arg);
+void keyedf(WDOperation *operation, void *arg);
+static int testCoalescedDeadlines(void);
+
+static unsigned int order[ITER+1], executed = 0;
+static unsigned int keyedOrder[2], keyedExecuted = 0;
+
+static struct timespec deadlineIn(long milliseconds) {
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += milliseconds / 1000;
+	deadline.tv_nsec += (milliseconds % 1000) * 1000000;
+	if (deadline.tv_nsec >= 1000000000) deadline.tv_sec++, deadline.tv_nsec -= 1000000000;
+	return deadline;
+}
+
+int main () {
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetName(operationQueue, "queue.deadline");
+	WDOperationQueueSetScheduling(operationQueue, WDOperationQueueSchedulingEDF);
+	WDOperationQueueSetDeadlineMissPolicy(operationQueue, WDOperationQueueDeadlineMissCancel);
+	WDOperationQueueSuspend(operationQueue, 1);
+	
+	/* The latest deadlines are added first */
+	static unsigned int identifiers[ITER];
+	for (unsigned int i=0; i<ITER; i++) {
+		identifiers[i] = ITER - i;
+		struct timespec deadline = deadlineIn(1000 * (long)identifiers[i]);
+		WDOperation *operation = WDOperationCreate(opf, &identifiers[i]);
+		WDOperationSetDeadline(operation, &deadline);
+		WDOperationQueueAddOperation(operationQueue, operation);
+		release(operation);
+	}
+	/* This one is already stale and should never be executed */
+	static unsigned int stale = 0;
+	struct timespec past = deadlineIn(0);
+	WDOperation *staleOperation = WDOperationCreate(opf, &stale);
+	WDOperationSetDeadline(staleOperation, &past);
+	WDOperationQueueAddOperation(operationQueue, staleOperation);
+	release(staleOperation);
+	
+	WDOperationQueueSuspend(operationQueue, 0);
+	WDOperationQueueWaitAllOperations(operationQueue);
+	
+	wd_operation_queue_statistics_t statistics;
+	WDOperationQueueGetStatistics(operationQueue, &statistics);
+	printf("executed %llu, met %llu, missed %llu, expired %llu\n", (unsigned long long)statistics.executed, (unsigned long long)statistics.deadlinesMet, (unsigned long long)statistics.deadlinesMissed, (unsigned long long)statistics.expired);
+	release(operationQueue);
+	
+	int ordered = executed == ITER;
+	for (unsigned int i=0; i<executed; i++)
+		ordered = ordered && order[i] == i+1;
+	return (ordered && statistics.expired == 1 && statistics.deadlinesMet == ITER && testCoalescedDeadlines()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int addKeyed(WDOperationQueue *queue, unsigned int *identifier, long milliseconds, int keyed) {
+	struct timespec deadline = deadlineIn(milliseconds);
+	WDOperation *operation = WDOperationCreate(keyedf, identifier);
+	WDOperationSetDeadline(operation, &deadline);
+	int result = keyed ? WDOperationQueueAddOperationWithKey(queue, operation, 17, NULL) : WDOperationQueueAddOperation(queue, operation);
+	release(operation);
+	return result;
+}
+
+/* A merge keeps the most urgent deadline and never joins an expired operation */
+static int testCoalescedDeadlines(void) {
+	static unsigned int keyed = 1, other = 2, fresh = 3;
+	struct timespec pause = { 0, 5000000 };
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetScheduling(operationQueue, WDOperationQueueSchedulingEDF);
+	WDOperationQueueSetDeadlineMissPolicy(operationQueue, WDOperationQueueDeadlineMissDrop);
+	
+	/* The keyed operation becomes more urgent than the other one */
+	WDOperationQueueSuspend(operationQueue, 1);
+	addKeyed(operationQueue, &keyed, 5000, 1);
+	addKeyed(operationQueue, &other, 2000, 0);
+	int merged = addKeyed(operationQueue, &keyed, 1000, 1) == 1;
+	WDOperationQueueSuspend(operationQueue, 0);
+	WDOperationQueueWaitAllOperations(operationQueue);
+	int urgent = merged && keyedExecuted == 2 && keyedOrder[0] == keyed && keyedOrder[1] == other;
+	
+	/* The fresh operation does not vanish into an expired one */
+	keyedExecuted = 0;
+	WDOperationQueueSuspend(operationQueue, 1);
+	addKeyed(operationQueue, &keyed, 1, 1);
+	nanosleep(&pause, NULL);
+	int added = addKeyed(operationQueue, &fresh, 10000, 1) == 0;
+	WDOperationQueueSuspend(operationQueue, 0);
+	WDOperationQueueWaitAllOperations(operationQueue);
+	int kept = added && keyedExecuted == 1 && keyedOrder[0] == fresh;
+	
+	/* A dropped operation leaves its queue like an executed one */
+	struct timespec past = deadlineIn(0);
+	WDOperation *dropped = WDOperationCreate(keyedf, &other);
+	WDOperationSetDeadline(dropped, &past);
+	WDOperationQueueAddOperation(operationQueue, dropped);
+	WDOperationWaitUntilFinished(dropped);
+	int detached = NULL == WDOperationCurrentOperationQueue(dropped) && 0 == WDOperationSetDeadline(dropped, NULL);
+	release(dropped);
+	
+	printf("coalesced deadline %s, fresh operation after an expired one %s, dropped operation %s\n", urgent ? "kept" : "lost", kept ? "executed" : "lost", detached ? "detached" : "still queued");
+	release(operationQueue);
+	return urgent && kept && detached;
+}
+
+void keyedf(WDOperation *operation, void *arg) {
+	(void)operation;
+	if (keyedExecuted < 2)
+		keyedOrder[keyedExecuted] = *(unsigned int *)arg;
+	keyedExecuted++;
+}
+
+void opf(WDOperation *operation, void *arg) {
+	unsigned int identifier = *(unsigned int *)arg;
+	printf("Executing operation %u in \"%s\"\n", identifier, WDOperationQueueGetName(WDOperationCurrentOperationQueue(operation)));
+	order[executed++] = identifier;
+}
@@ -0,0 +1,118 @@
+//
+//  testElasticPool.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __linux__
+#include <dirent.h>
+#endif
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define ITER 16
+#define WORKERS 8
+#define BLOCKING_MS 100
+#define BUSY_MS 500
+#define BACKLOG_MS 50
+#define IDLE_MS 100
+
+void blockingf(WDOperation *operation, void *arg);
+void busyf(WDOperation *operation, void *arg);
+void startf(WDOperation *operation, void *arg);
+
+static struct timespec start;
+static double started;
+static unsigned int startedThreads;
+
+static double elapsed(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)(now.tv_sec - start->tv_sec) * 1000.0 + (double)(now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+/* The number of threads of the process, 0 when it is unknown */
+static unsigned int threads(void) {
+	unsigned int count = 0;
+#ifdef __linux__
+	DIR *directory = opendir("/proc/self/task");
+	if (NULL == directory) return 0;
+	struct dirent *entry;
+	while (NULL != (entry = readdir(directory))) {
+		if ('.' != entry->d_name[0])
+			count++;
+	}
+	closedir(directory);
+#endif
+	return count;
+}
+
+int main () {
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetName(operationQueue, "queue.elastic");
+	WDOperationQueueSetWorkerLimits(operationQueue, 1, WORKERS);
+	WDOperationQueueSetIdleTimeout(operationQueue, IDLE_MS);
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i=0; i<ITER; i++) {
+		WDOperation *operation = WDOperationCreate(blockingf, NULL);
+		WDOperationQueueAddOperation(operationQueue, operation);
+		release(operation);
+	}
+	WDOperationQueueWaitAllOperations(operationQueue);
+	double milliseconds = elapsed(&start);
+	
+	/* A serial queue would need ITER * BLOCKING_MS */
+	printf("%d blocking operations of %d ms finished in %.0f ms\n", ITER, BLOCKING_MS, milliseconds);
+	release(operationQueue);
+	
+	/* An operation that does not declare its blocking section, the next one may only wait for the backlog threshold */
+	WDOperationQueue *backlogQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetWorkerLimits(backlogQueue, 1, 2);
+	WDOperationQueueSetBacklogThreshold(backlogQueue, BACKLOG_MS);
+	WDOperationQueueSetIdleTimeout(backlogQueue, IDLE_MS);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	WDOperation *busy = WDOperationCreate(busyf, NULL);
+	WDOperationQueueAddOperation(backlogQueue, busy);
+	release(busy);
+	nanosleep(&(struct timespec){ 0, 10000000 }, NULL);
+	WDOperation *waiting = WDOperationCreate(startf, NULL);
+	WDOperationQueueAddOperation(backlogQueue, waiting);
+	release(waiting);
+	WDOperationQueueWaitAllOperations(backlogQueue);
+	printf("an operation behind a busy worker started after %.0f ms with a backlog threshold of %d ms\n", started, BACKLOG_MS);
+	
+	/* Both workers were running when the second operation started, let them retire */
+	nanosleep(&(struct timespec){ 0, 3 * IDLE_MS * 1000000 }, NULL);
+	unsigned int idleThreads = threads();
+	printf("%u threads with both workers, %u once idle\n", startedThreads, idleThreads);
+	release(backlogQueue);
+	
+	int elastic = milliseconds < (ITER * BLOCKING_MS) / 2;
+	int grown = started < BUSY_MS / 2;
+	int retired = 0 == startedThreads || idleThreads + 2 == startedThreads;
+	return elastic && grown && retired ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void blockingf(WDOperation *operation, void *arg) {
+	(void)arg;
+	WDOperationBeginBlocking(operation);
+	nanosleep(&(struct timespec){ 0, BLOCKING_MS * 1000000 }, NULL);
+	WDOperationEndBlocking(operation);
+}
+
+void busyf(WDOperation *operation, void *arg) {
+	(void)operation, (void)arg;
+	nanosleep(&(struct timespec){ 0, BUSY_MS * 1000000 }, NULL);
+}
+
+void startf(WDOperation *operation, void *arg) {
+	(void)operation, (void)arg;
+	started = elapsed(&start);
+	startedThreads = threads();
+}
@@ -0,0 +1,98 @@
+//
+//  testHelpingWait.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define N 16
+
+struct fibonacci {
+	unsigned int n;
+	unsigned long result;
+};
+
+void fibonaccif(WDOperation *operation, void *arg);
+void parentf(WDOperation *operation, void *arg);
+void childf(WDOperation *operation, void *arg);
+
+static unsigned int children;
+
+static unsigned long fibonacci(unsigned int n) {
+	return n < 2 ? n : fibonacci(n-1) + fibonacci(n-2);
+}
+
+int main () {
+	/* A serial queue, every child is awaited from within its parent */
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetName(operationQueue, "queue.forkjoin");
+	
+	struct fibonacci *root = MEMORY_MANAGEMENT_ALLOC(sizeof(struct fibonacci));
+	root->n = N;
+	WDOperation *operation = WDOperationCreate(fibonaccif, root);
+	WDOperationQueueAddOperation(operationQueue, operation);
+	WDOperationWaitUntilFinished(operation);
+	
+	printf("fibonacci(%d) = %lu\n", N, root->result);
+	int success = root->result == fibonacci(N);
+	release(operation);
+	
+	/* The parent releases its child before waiting on it, the queue holds the last reference */
+	operation = WDOperationCreate(parentf, NULL);
+	WDOperationQueueAddOperation(operationQueue, operation);
+	WDOperationWaitUntilFinished(operation);
+	release(operation);
+	printf("%u children executed after their release\n", children);
+	success = success && children == N;
+	release(root);
+	release(operationQueue);
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void fibonaccif(WDOperation *operation, void *arg) {
+	struct fibonacci *fibonacci = arg;
+	if (fibonacci->n < 2) {
+		fibonacci->result = fibonacci->n;
+		return;
+	}
+	
+	WDOperationQueue *queue = WDOperationCurrentOperationQueue(operation);
+	struct fibonacci *arguments[2];
+	WDOperation *children[2];
+	for (unsigned int i=0; i<2; i++) {
+		arguments[i] = MEMORY_MANAGEMENT_ALLOC(sizeof(struct fibonacci));
+		arguments[i]->n = fibonacci->n - 1 - i;
+		children[i] = WDOperationCreate(fibonaccif, arguments[i]);
+		WDOperationQueueAddOperation(queue, children[i]);
+	}
+	
+	fibonacci->result = 0;
+	for (unsigned int i=0; i<2; i++) {
+		WDOperationWaitUntilFinished(children[i]);
+		fibonacci->result += arguments[i]->result;
+		release(children[i]);
+		release(arguments[i]);
+	}
+}
+
+void parentf(WDOperation *operation, void *arg) {
+	(void)arg;
+	WDOperationQueue *queue = WDOperationCurrentOperationQueue(operation);
+	for (unsigned int i=0; i<N; i++) {
+		WDOperation *child = WDOperationCreate(childf, NULL);
+		WDOperationQueueAddOperation(queue, child);
+		release(child);
+		WDOperationWaitUntilFinished(child);
+	}
+}
+
+void childf(WDOperation *operation, void *arg) {
+	(void)operation, (void)arg;
+	children++;
+}
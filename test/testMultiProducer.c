@@ -0,0 +1,100 @@
+//
+//  testMultiProducer.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define PRODUCERS 4
+#define ITER 50000
+#define WORKERS 2
+
+void opf(WDOperation *operation, void *arg);
+void *producerf(void *arg);
+
+static unsigned long executed = 0;
+
+/* Counts the cache misses of the process and of the threads it creates, when the hardware allows it */
+static int openCacheMissCounter(void) {
+#ifdef __linux__
+	struct perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = PERF_TYPE_HARDWARE;
+	attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+	attributes.disabled = 1;
+	attributes.inherit = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+	return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+int main () {
+	WDOperationQueue *operationQueue = WDOperationQueueAllocate();
+	WDOperationQueueSetName(operationQueue, "queue.multiproducer");
+	WDOperationQueueSetWorkerLimits(operationQueue, WORKERS, WORKERS);
+	
+	int counter = openCacheMissCounter();
+#ifdef __linux__
+	if (counter >= 0) ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	
+	pthread_t producers[PRODUCERS];
+	for (unsigned int i=0; i<PRODUCERS; i++)
+		pthread_create(&producers[i], NULL, producerf, operationQueue);
+	for (unsigned int i=0; i<PRODUCERS; i++)
+		pthread_join(producers[i], NULL);
+	WDOperationQueueWaitAllOperations(operationQueue);
+	
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double milliseconds = (double)(end.tv_sec - start.tv_sec) * 1000.0 + (double)(end.tv_nsec - start.tv_nsec) / 1000000.0;
+	printf("%d producers added %d operations in %.1f ms (%.0f operations/s)\n", PRODUCERS, PRODUCERS * ITER, milliseconds, PRODUCERS * ITER / milliseconds * 1000.0);
+	
+	long long misses = 0;
+#ifdef __linux__
+	if (counter >= 0 && read(counter, &misses, sizeof(misses)) == sizeof(misses))
+		printf("cache misses: %lld (%.2f per operation)\n", misses, (double)misses / (PRODUCERS * ITER));
+	else
+#endif
+		printf("cache misses: not available on this system\n");
+	
+	release(operationQueue);
+	return __atomic_load_n(&executed, __ATOMIC_RELAXED) == PRODUCERS * ITER ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void *producerf(void *arg) {
+	WDOperationQueue *queue = arg;
+	for (unsigned int i=0; i<ITER; i++) {
+		WDOperation *operation = WDOperationCreate(opf, NULL);
+		WDOperationQueueAddOperation(queue, operation);
+		release(operation);
+	}
+	return NULL;
+}
+
+void opf(WDOperation *operation, void *arg) {
+	(void)operation, (void)arg;
+	__atomic_add_fetch(&executed, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,167 @@
+//
+//  testPipeline.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pipeline.h"
+#include <memory_management/memory_management.h>
+
+#define ITEMS 200000
+#define CAPACITY 1024
+#define STAGES 3
+
+struct record {
+	unsigned int sequence;
+	unsigned long value;
+};
+
+struct sink {
+	unsigned int next; /* the sequence expected by the last stage */
+	unsigned int misordered;
+	unsigned long total;
+	unsigned int received;
+};
+
+static WDOperationQueue *queues[STAGES];
+static struct sink handoffSink;
+
+void *parsef(void *item, void *context);
+void *squaref(void *item, void *context);
+void *sinkf(void *item, void *context);
+void handoffParsef(WDOperation *operation, void *arg);
+void handoffSquaref(WDOperation *operation, void *arg);
+void handoffSinkf(WDOperation *operation, void *arg);
+static double elapsedSince(struct timespec *start);
+
+int main () {
+	struct timespec start, pause = { 0, 10000 };
+	struct record *records = MEMORY_MANAGEMENT_ALLOC(ITEMS * sizeof(struct record));
+	unsigned long expected = 0;
+	for (unsigned int i=0; i<ITEMS; i++) {
+		records[i].sequence = i;
+		expected += (unsigned long)(i % 1000) * (i % 1000);
+	}
+	for (unsigned int i=0; i<STAGES; i++)
+		queues[i] = WDOperationQueueAllocate();
+	/* The order of a stage holds even on a queue with several workers */
+	WDOperationQueueSetWorkerLimits(queues[1], 2, 2);
+
+	/* One operation per item and per stage */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i=0; i<ITEMS; i++) {
+		WDOperation *operation = WDOperationCreate(handoffParsef, &records[i]);
+		WDOperationQueueAddOperation(queues[0], operation);
+		release(operation);
+	}
+	for (unsigned int i=0; i<STAGES; i++)
+		WDOperationQueueWaitAllOperations(queues[i]);
+	double handoff = elapsedSince(&start);
+	printf("hand-off: %u items in %.3f s (%.0f items/s)\n", ITEMS, handoff, ITEMS / handoff);
+
+	/* The same stages connected by rings */
+	struct sink sink = { 0, 0, 0, 0 };
+	WDPipeline *pipeline = WDPipelineAllocate();
+	WDPipelineAddStage(pipeline, queues[0], parsef, NULL, CAPACITY);
+	WDPipelineAddStage(pipeline, queues[1], squaref, NULL, CAPACITY);
+	WDPipelineAddStage(pipeline, queues[2], sinkf, &sink, CAPACITY);
+	WDPipelineSetBatchSize(pipeline, 64);
+	WDPipelineSetFlushLatency(pipeline, 500);
+	WDPipelineStart(pipeline);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i=0; i<ITEMS; i++) {
+		while (WDPipelinePush(pipeline, &records[i]) < 0)
+			nanosleep(&pause, NULL);
+	}
+	WDPipelineWaitAllItems(pipeline);
+	double pipelined = elapsedSince(&start);
+	printf("pipeline: %u items in %.3f s (%.0f items/s)\n", ITEMS, pipelined, ITEMS / pipelined);
+
+	for (unsigned int i=0; i<STAGES; i++) {
+		wd_pipeline_stage_statistics_t statistics;
+		WDPipelineGetStageStatistics(pipeline, i, &statistics);
+		printf("stage %u: %llu items in %llu batches, %.0f items/s busy, queueing delay %.1f us average %.1f us maximum\n", i,
+			   (unsigned long long)statistics.items, (unsigned long long)statistics.batches,
+			   statistics.busyTime ? statistics.items * 1e9 / statistics.busyTime : 0.0,
+			   statistics.items ? statistics.queueingDelay / 1e3 / statistics.items : 0.0,
+			   statistics.maximumQueueingDelay / 1e3);
+	}
+
+	/* An incomplete batch is flushed once the latency elapses */
+	struct record last = { ITEMS, 0 };
+	struct timespec latency = { 0, 50000000 };
+	WDPipelinePush(pipeline, &last);
+	nanosleep(&latency, NULL);
+	int flushed = __atomic_load_n(&sink.received, __ATOMIC_ACQUIRE) == ITEMS + 1;
+
+	release(pipeline);
+	for (unsigned int i=0; i<STAGES; i++)
+		release(queues[i]);
+	release(records);
+
+	printf("%u items received, %u out of order, total %lu (expected %lu), incomplete batch %s\n", sink.received, sink.misordered, sink.total, expected, flushed ? "flushed" : "stuck");
+	int ok = sink.misordered == 0 && sink.total == expected && flushed
+		&& handoffSink.misordered == 0 && handoffSink.total == expected;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static double elapsedSince(struct timespec *start) {
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void *parsef(void *item, void *context) {
+	(void)context;
+	struct record *record = item;
+	record->value = record->sequence % 1000;
+	return record;
+}
+
+void *squaref(void *item, void *context) {
+	(void)context;
+	struct record *record = item;
+	record->value *= record->value;
+	return record;
+}
+
+void *sinkf(void *item, void *context) {
+	struct record *record = item;
+	struct sink *sink = context;
+	if (record->sequence != sink->next)
+		sink->misordered++;
+	sink->next = record->sequence + 1;
+	sink->total += record->value;
+	__atomic_add_fetch(&sink->received, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+void handoffParsef(WDOperation *operation, void *arg) {
+	(void)operation;
+	parsef(arg, NULL);
+	WDOperation *next = WDOperationCreate(handoffSquaref, arg);
+	WDOperationQueueAddOperation(queues[1], next);
+	release(next);
+}
+
+void handoffSquaref(WDOperation *operation, void *arg) {
+	(void)operation;
+	squaref(arg, NULL);
+	WDOperation *next = WDOperationCreate(handoffSinkf, arg);
+	WDOperationQueueAddOperation(queues[2], next);
+	release(next);
+}
+
+void handoffSinkf(WDOperation *operation, void *arg) {
+	(void)operation;
+	/* Two workers run the middle stage, the hand-off does not keep the order */
+	struct record *record = arg;
+	handoffSink.total += record->value;
+	handoffSink.received++;
+}
@@ -0,0 +1,87 @@
+//
+//  testQueueStartup.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef __linux__
+#include <dirent.h>
+#endif
+#include "operationQueue.h"
+#include <memory_management/memory_management.h>
+
+#define QUEUES 10000
+#define CREATION_BOUND_MS 1000 /* a thread per queue would not fit */
+#define IDLE_MS 50
+
+void opf(WDOperation *operation, void *arg);
+
+static double elapsed(const struct timespec *start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)(now.tv_sec - start->tv_sec) * 1000.0 + (double)(now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+/* The number of threads of the process, 0 when it is unknown */
+static unsigned int threads(void) {
+	unsigned int count = 0;
+#ifdef __linux__
+	DIR *directory = opendir("/proc/self/task");
+	if (NULL == directory) return 0;
+	struct dirent *entry;
+	while (NULL != (entry = readdir(directory))) {
+		if ('.' != entry->d_name[0])
+			count++;
+	}
+	closedir(directory);
+#endif
+	return count;
+}
+
+int main () {
+	static WDOperationQueue *queues[QUEUES];
+	unsigned int initialThreads = threads();
+	
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i=0; i<QUEUES; i++)
+		queues[i] = WDOperationQueueAllocate();
+	double creation = elapsed(&start);
+	unsigned int createdThreads = threads();
+	printf("Created %d queues in %.2f ms, %u threads before and %u after\n", QUEUES, creation, initialThreads, createdThreads);
+	
+	/* Only the queues that receive operations start a worker */
+	char *string = "Hello from a lazily started queue";
+	WDOperationQueueSetIdleTimeout(queues[QUEUES/2], IDLE_MS);
+	WDOperation *operation = WDOperationCreate(opf, string);
+	WDOperationQueueAddOperation(queues[QUEUES/2], operation);
+	WDOperationWaitUntilFinished(operation);
+	release(operation);
+	unsigned int workingThreads = threads();
+	
+	/* The worker retires once idle */
+	nanosleep(&(struct timespec){ 0, 3 * IDLE_MS * 1000000 }, NULL);
+	unsigned int idleThreads = threads();
+	printf("%u threads with a worker, %u once it is idle\n", workingThreads, idleThreads);
+	
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int i=0; i<QUEUES; i++)
+		release(queues[i]);
+	printf("Released %d queues in %.2f ms\n", QUEUES, elapsed(&start));
+	
+	/* The threads are only counted on Linux */
+	int lazy = 0 == initialThreads || (createdThreads == initialThreads && workingThreads > initialThreads);
+	int retired = 0 == initialThreads || idleThreads + 1 == workingThreads;
+	return creation < CREATION_BOUND_MS && lazy && retired ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void opf(WDOperation *operation, void *arg) {
+	char *string = arg;
+	puts(string);
+	puts(WDOperationQueueGetName(WDOperationCurrentOperationQueue(operation)));
+}
@@ -0,0 +1,113 @@
+//
+//  testShardedDispatcher.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "shardedDispatcher.h"
+#include <memory_management/memory_management.h>
+
+#define LANES 16
+#define WORKERS 4
+#define KEYS 100000
+#define PER_KEY 8
+#define HOT 2000
+#define COLD 1000
+
+struct account {
+	unsigned int next; /* the sequence number expected by the account */
+	unsigned int misordered;
+};
+
+struct deposit {
+	struct account *account;
+	unsigned int sequence;
+};
+
+static volatile int gate = 0;
+
+void depositf(WDOperation *operation, void *arg);
+void gatef(WDOperation *operation, void *arg);
+static int dispatchDeposit(WDShardedDispatcher *dispatcher, uint64_t key, struct account *account, unsigned int sequence);
+static unsigned int misordered(struct account *accounts, unsigned int count, unsigned int expected);
+
+int main () {
+	struct timespec start, end;
+	int result = EXIT_SUCCESS;
+
+	/* Many keys, the functions of each key must run in order */
+	struct account *accounts = calloc(KEYS, sizeof(struct account));
+	WDShardedDispatcher *dispatcher = WDShardedDispatcherAllocate(LANES, WORKERS);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned int sequence=0; sequence<PER_KEY; sequence++) {
+		for (unsigned int key=0; key<KEYS; key++)
+			dispatchDeposit(dispatcher, key, &accounts[key], sequence);
+	}
+	WDShardedDispatcherWaitAllFunctions(dispatcher);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	unsigned int wrong = misordered(accounts, KEYS, PER_KEY);
+	printf("%u functions over %u keys in %.3f s (%.0f functions/s), %u keys out of order\n", KEYS * PER_KEY, KEYS, elapsed, KEYS * PER_KEY / elapsed, wrong);
+	if (wrong != 0)
+		result = EXIT_FAILURE;
+	release(dispatcher);
+	free(accounts);
+
+	/* A hot key piles up in its lane, the new keys hashed to that lane go elsewhere */
+	accounts = calloc(1 + COLD, sizeof(struct account));
+	dispatcher = WDShardedDispatcherAllocate(LANES, WORKERS);
+	WDShardedDispatcherDispatch(dispatcher, 0, gatef, NULL);
+	for (unsigned int sequence=0; sequence<HOT; sequence++)
+		dispatchDeposit(dispatcher, 0, &accounts[0], sequence);
+	for (unsigned int key=1; key<=COLD; key++)
+		dispatchDeposit(dispatcher, key, &accounts[key], 0);
+	__atomic_store_n(&gate, 1, __ATOMIC_RELEASE);
+	WDShardedDispatcherWaitAllFunctions(dispatcher);
+	uint64_t rebalanced = WDShardedDispatcherGetRebalancedKeys(dispatcher);
+	wrong = misordered(accounts, 1, HOT) + misordered(accounts + 1, COLD, 1);
+	printf("%llu keys moved away from the hot lane, %u keys out of order\n", (unsigned long long)rebalanced, wrong);
+	if (wrong != 0 || rebalanced == 0)
+		result = EXIT_FAILURE;
+	release(dispatcher);
+	free(accounts);
+
+	return result;
+}
+
+static int dispatchDeposit(WDShardedDispatcher *dispatcher, uint64_t key, struct account *account, unsigned int sequence) {
+	struct deposit *deposit = MEMORY_MANAGEMENT_ALLOC(sizeof(struct deposit));
+	deposit->account = account;
+	deposit->sequence = sequence;
+	int result = WDShardedDispatcherDispatch(dispatcher, key, depositf, deposit);
+	release(deposit);
+	return result;
+}
+
+static unsigned int misordered(struct account *accounts, unsigned int count, unsigned int expected) {
+	unsigned int wrong = 0;
+	for (unsigned int i=0; i<count; i++) {
+		if (accounts[i].misordered || accounts[i].next != expected)
+			wrong++;
+	}
+	return wrong;
+}
+
+void depositf(WDOperation *operation, void *arg) {
+	(void)operation;
+	struct deposit *deposit = arg;
+	if (deposit->account->next != deposit->sequence)
+		deposit->account->misordered++;
+	deposit->account->next = deposit->sequence + 1;
+}
+
+void gatef(WDOperation *operation, void *arg) {
+	(void)operation, (void)arg;
+	struct timespec pause = { 0, 1000000 };
+	while (!__atomic_load_n(&gate, __ATOMIC_ACQUIRE))
+		nanosleep(&pause, NULL);
+}
@@ -0,0 +1,160 @@
+//
+//  testSharedQueue.c
+//  workdipatcher
+//
+//  Created by George Boumis on 18/10/26.
+//  Copyright (c) 2026 George Boumis <developer.george.boumis@gmail.com>. All rights reserved.
+//
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "sharedQueue.h"
+#include <memory_management/memory_management.h>
+
+#ifdef __linux__
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define WORKERS 3
+#define OPERATIONS 20000
+#define TRICKLE 50 /* operations added every TRICKLE_MS, the workers never wait long enough to time out */
+#define TRICKLE_MS 20
+#define CAPACITY 128
+#define SUM 1
+#define CRASH 2
+
+struct results {
+	unsigned long total; /* the sum of the payloads, written by the workers */
+	unsigned int crashed;
+	unsigned int survived;
+};
+
+static struct results *results;
+
+void sumf(WDSharedQueue *queue, void *payload, size_t size);
+void crashf(WDSharedQueue *queue, void *payload, size_t size);
+static void work(int fd);
+static int testSteadyProducer(void);
+
+int main () {
+	results = mmap(NULL, sizeof(struct results), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	WDSharedQueueRegisterFunction(SUM, sumf);
+	WDSharedQueueRegisterFunction(CRASH, crashf);
+	WDSharedQueue *queue = WDSharedQueueCreate("testSharedQueue", CAPACITY, sizeof(unsigned long));
+
+	pid_t workers[WORKERS];
+	for (unsigned int i=0; i<WORKERS; i++) {
+		if (0 == (workers[i] = fork()))
+			work(WDSharedQueueGetFileDescriptor(queue));
+	}
+
+	/* The first worker taking this operation dies with it, another worker executes it again */
+	WDSharedQueueAddOperation(queue, CRASH, NULL, 0, -1);
+	unsigned long expected = 0;
+	struct timespec start, now, pause = { 0, 10000000 };
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long i=1; i<=OPERATIONS; i++) {
+		WDSharedQueueAddOperation(queue, SUM, &i, sizeof(i), -1);
+		expected += i;
+	}
+
+	/* Reap the dead worker so that its operation is recovered */
+	unsigned int dead = 0;
+	wd_shared_queue_statistics_t statistics;
+	do {
+		int status;
+		pid_t pid = waitpid(-1, &status, WNOHANG);
+		if (pid > 0 && WIFSIGNALED(status))
+			dead++;
+		nanosleep(&pause, NULL);
+		WDSharedQueueGetStatistics(queue, &statistics);
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while (statistics.executed < OPERATIONS + 1 && now.tv_sec - start.tv_sec < 10);
+	double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+
+	WDSharedQueueShutdown(queue);
+	for (unsigned int i=0; i<WORKERS; i++) {
+		int status;
+		if (waitpid(workers[i], &status, 0) > 0 && WIFSIGNALED(status))
+			dead++;
+	}
+
+	printf("%llu operations executed by %u processes in %.3f s, %llu recovered, %llu abandoned, %u worker died\n",
+		   (unsigned long long)statistics.executed, WORKERS, elapsed, (unsigned long long)statistics.recovered,
+		   (unsigned long long)statistics.abandoned, dead);
+	printf("total %lu (expected %lu), crashing operation executed %u time(s) after the crash\n", results->total, expected, results->survived);
+	int ok = results->total == expected && statistics.executed == OPERATIONS + 1 && statistics.recovered == 1
+		&& results->survived == 1 && dead == 1;
+	release(queue);
+	ok = testSteadyProducer() && ok;
+	munmap(results, sizeof(struct results));
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* A worker dies while the other one is kept busy, its operation is recovered without any wait timing out */
+static int testSteadyProducer(void) {
+	WDSharedQueue *queue = WDSharedQueueCreate("testSharedQueue.steady", CAPACITY, sizeof(unsigned long));
+	results->crashed = results->survived = 0;
+	pid_t workers[2];
+	for (unsigned int i=0; i<2; i++) {
+		if (0 == (workers[i] = fork()))
+			work(WDSharedQueueGetFileDescriptor(queue));
+	}
+
+	WDSharedQueueAddOperation(queue, CRASH, NULL, 0, -1);
+	struct timespec pause = { 0, TRICKLE_MS * 1000000 };
+	for (unsigned long i=0; i<TRICKLE; i++) {
+		WDSharedQueueAddOperation(queue, SUM, &i, sizeof(i), -1);
+		nanosleep(&pause, NULL);
+	}
+	wd_shared_queue_statistics_t statistics;
+	WDSharedQueueGetStatistics(queue, &statistics);
+
+	WDSharedQueueShutdown(queue);
+	for (unsigned int i=0; i<2; i++)
+		waitpid(workers[i], NULL, 0);
+	release(queue);
+	printf("steady producer: %llu recovered, crashing operation executed %u time(s) after the crash\n",
+		   (unsigned long long)statistics.recovered, results->survived);
+	return statistics.recovered == 1 && results->survived == 1;
+}
+
+static void work(int fd) {
+	WDSharedQueue *queue = WDSharedQueueOpen(fd);
+	while (WDSharedQueuePerformNext(queue, -1) == 0 || errno != ECANCELED)
+		;
+	release(queue);
+	_exit(EXIT_SUCCESS);
+}
+
+void sumf(WDSharedQueue *queue, void *payload, size_t size) {
+	(void)queue, (void)size;
+	unsigned long value;
+	memcpy(&value, payload, sizeof(value));
+	__atomic_add_fetch(&results->total, value, __ATOMIC_RELAXED);
+}
+
+void crashf(WDSharedQueue *queue, void *payload, size_t size) {
+	(void)queue, (void)payload, (void)size;
+	if (__atomic_exchange_n(&results->crashed, 1, __ATOMIC_SEQ_CST) == 0)
+		raise(SIGKILL);
+	__atomic_add_fetch(&results->survived, 1, __ATOMIC_RELAXED);
+}
+
+#else
+
+int main () {
+	puts("Shared queues are available on Linux only");
+	return EXIT_SUCCESS;
+}
+
+#endif